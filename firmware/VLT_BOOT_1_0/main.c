@@ -0,0 +1,346 @@
+#include "main.h"
+
+// Resident UART bootloader (BOOT section)
+//
+// Frames use the firmware frame protocol (lib/utils/frame), polled:
+// Boot    -> Ack(application start, application size), opens a session
+// Program -> address(3) | page(64), Ack(next address) after erase/write
+// Verify  -> length(3) | CRC16(2), Ack(length) if the flash image matches
+// Run     -> Ack, starts the (verified) application
+//
+// Without a Boot frame within BOOT_TIMEOUT the application is started,
+// an unverified or interrupted image keeps the bootloader active.
+
+typedef struct
+{
+	unsigned int length;
+	unsigned int crc;
+} BOOT_Record;
+
+static FRAME_Data boot_frame;
+
+static unsigned long boot_get_address(const unsigned char *data)
+{
+	return (unsigned long)data[0] | ((unsigned long)data[1] << 8) | ((unsigned long)data[2] << 16);
+}
+
+static void boot_set_address(unsigned char *data, unsigned long address)
+{
+	data[0] = (unsigned char)address;
+	data[1] = (unsigned char)(address >> 8);
+	data[2] = (unsigned char)(address >> 16);
+}
+
+static void boot_uart_init(void)
+{
+	PORTMUX.CTRLB |= PORTMUX_USART0_bm;
+	BOOT_UART_PORT.DIRSET = BOOT_UART_TX;
+
+	USART0.BAUD = BOOT_BAUD_REGISTER;
+	USART0.CTRLB = USART_RXEN_bm | USART_TXEN_bm;
+}
+
+// Free running 1.024kHz count (~ms) for the listen and session deadlines
+static void boot_timer_init(void)
+{
+	RTC.CLKSEL = RTC_CLKSEL_INT1K_gc;
+	RTC.CTRLA = RTC_RTCEN_bm;
+}
+
+// Leaves the peripherals in reset state for the application
+static void boot_uart_disable(void)
+{
+	USART0.CTRLB = 0;
+	USART0.BAUD = 0;
+
+	BOOT_UART_PORT.DIRCLR = BOOT_UART_TX;
+	PORTMUX.CTRLB &= ~PORTMUX_USART0_bm;
+
+	RTC.CTRLA = 0;
+	while(RTC.STATUS);
+	RTC.CNT = 0;
+	while(RTC.STATUS);
+	RTC.CLKSEL = 0;
+}
+
+static void boot_putchar(unsigned char data)
+{
+	while(!(USART0.STATUS & USART_DREIF_bm));
+
+	USART0.STATUS = USART_TXCIF_bm;
+	USART0.TXDATAL = data;
+}
+
+// timeout in ms
+static unsigned char boot_getchar(unsigned char *data, unsigned int timeout)
+{
+	unsigned long polls = (unsigned long)timeout * 100UL;
+
+	while(!(USART0.STATUS & USART_RXCIF_bm))
+	{
+		if(!(polls--))
+		{
+			return 0;
+		}
+		_delay_us(10);
+	}
+	*data = USART0.RXDATAL;
+
+	return 1;
+}
+
+// Waits for a frame until the RTC reaches deadline (expire), bytes in between
+// (application traffic, noise) do not extend it
+static FRAME_Status boot_receive(unsigned char expire, unsigned int deadline)
+{
+	unsigned char *data = &boot_frame.start;
+	unsigned int crc = 0;
+
+	do
+	{
+		while(!(USART0.STATUS & USART_RXCIF_bm))
+		{
+			if(expire && ((int)(RTC.CNT - deadline) >= 0))
+			{
+				return FRAME_Status_Empty;
+			}
+		}
+		*data = USART0.RXDATAL;
+	} while(*data != FRAME_START);
+
+	boot_frame.length = 0;
+
+	for (unsigned char i=1; i < (FRAME_HEADER_SIZE + boot_frame.length + FRAME_CRC_SIZE); i++)
+	{
+		if(!boot_getchar(&data[i], BOOT_BYTE_TIMEOUT) || (boot_frame.length > FRAME_PAYLOAD_SIZE))
+		{
+			return FRAME_Status_Corrupt;
+		}
+
+		if(i < (FRAME_HEADER_SIZE + boot_frame.length))
+		{
+			crc = _crc_xmodem_update(crc, data[i]);
+		}
+	}
+
+	if(crc != (unsigned int)(boot_frame.payload[boot_frame.length] | (boot_frame.payload[boot_frame.length + 1] << 8)))
+	{
+		return FRAME_Status_Corrupt;
+	}
+	return FRAME_Status_Ready;
+}
+
+// Replies with the sequence number of the received frame
+static void boot_reply(FRAME_Command command, unsigned long address, unsigned long length)
+{
+	unsigned char *data = &boot_frame.start;
+	unsigned int crc = 0;
+
+	boot_frame.start = FRAME_START;
+	boot_frame.command = command;
+	boot_frame.length = 2 * FRAME_ADDRESS_SIZE;
+	boot_set_address(&boot_frame.payload[0], address);
+	boot_set_address(&boot_frame.payload[FRAME_ADDRESS_SIZE], length);
+
+	boot_putchar(*data);
+
+	for (unsigned char i=1; i < (FRAME_HEADER_SIZE + (2 * FRAME_ADDRESS_SIZE)); i++)
+	{
+		crc = _crc_xmodem_update(crc, data[i]);
+		boot_putchar(data[i]);
+	}
+	boot_putchar((unsigned char)crc);
+	boot_putchar((unsigned char)(crc >> 8));
+}
+
+// The CPU is halted until the page is programmed
+static void boot_nvm(unsigned char command)
+{
+	_PROTECTED_WRITE_SPM(NVMCTRL.CTRLA, command);
+	while(NVMCTRL.STATUS & (NVMCTRL_FBUSY_bm | NVMCTRL_EEBUSY_bm));
+}
+
+static void boot_record_write(unsigned int length, unsigned int crc)
+{
+	volatile BOOT_Record *record = (volatile BOOT_Record *)BOOT_RECORD;
+
+	boot_nvm(NVMCTRL_CMD_PAGEBUFCLR_gc);
+	record->length = length;
+	record->crc = crc;
+	boot_nvm(NVMCTRL_CMD_PAGEERASEWRITE_gc);
+}
+
+static unsigned int boot_crc(unsigned int length)
+{
+	const unsigned char *data = (const unsigned char *)(MAPPED_PROGMEM_START + BOOT_SIZE);
+	unsigned int crc = 0;
+
+	while(length--)
+	{
+		crc = _crc_xmodem_update(crc, *(data++));
+	}
+	return crc;
+}
+
+static unsigned char boot_application_valid(void)
+{
+	const volatile BOOT_Record *record = (const volatile BOOT_Record *)BOOT_RECORD;
+	unsigned int length = record->length;
+
+	if(*(const volatile unsigned int *)(MAPPED_PROGMEM_START + BOOT_SIZE) == 0xFFFFU)
+	{
+		return 0;
+	}
+
+	if(length == BOOT_RECORD_ERASED)
+	{
+		return 1;
+	}
+	return (length && (length <= BOOT_APPLICATION_SIZE) && (boot_crc(length) == record->crc));
+}
+
+static void boot_application(void)
+{
+	boot_uart_disable();
+
+	IO_PORT.OUTCLR = LED;
+	IO_PORT.DIRCLR = LED;
+
+	_PROTECTED_WRITE(CLKCTRL.MCLKCTRLB, CLKCTRL_PDIV_6X_gc | CLKCTRL_PEN_bm);
+
+	// Application can neither read nor call into the bootloader
+	NVMCTRL.CTRLB = NVMCTRL_BOOTLOCK_bm;
+
+	((void (*)(void))(BOOT_SIZE / 2U))();
+}
+
+static unsigned char boot_program(void)
+{
+	unsigned long address = boot_get_address(boot_frame.payload);
+	unsigned char *page = (unsigned char *)(MAPPED_PROGMEM_START + address);
+
+	if(	(boot_frame.length != (FRAME_ADDRESS_SIZE + PROGMEM_PAGE_SIZE)) ||
+		(address < BOOT_SIZE) || (address > (PROGMEM_SIZE - PROGMEM_PAGE_SIZE)) ||
+		(address % PROGMEM_PAGE_SIZE))
+	{
+		return 0;
+	}
+
+	for (unsigned char i=0; i < PROGMEM_PAGE_SIZE; i++)
+	{
+		page[i] = boot_frame.payload[FRAME_ADDRESS_SIZE + i];
+	}
+	boot_nvm(NVMCTRL_CMD_PAGEERASEWRITE_gc);
+
+	return 1;
+}
+
+int main(void)
+{
+	unsigned char valid;
+	unsigned char session = 0;
+	unsigned char programming = 0;
+	unsigned int deadline = BOOT_TIMEOUT;
+
+	_PROTECTED_WRITE(CLKCTRL.MCLKCTRLB, 0);
+
+	boot_timer_init();
+	boot_uart_init();
+	IO_PORT.DIRSET = LED;
+
+	valid = boot_application_valid();
+
+	if(!valid)
+	{
+		IO_PORT.OUTSET = LED;
+	}
+
+	while(1)
+	{
+		FRAME_Status status = boot_receive(valid, deadline);
+
+		// Only possible with a valid application
+		if(status == FRAME_Status_Empty)
+		{
+			boot_application();
+		}
+
+		// Frames before the Boot handshake are application traffic
+		if(!session && ((status != FRAME_Status_Ready) || (boot_frame.command != FRAME_Command_Boot)))
+		{
+			continue;
+		}
+
+		if(status != FRAME_Status_Ready)
+		{
+			boot_reply(FRAME_Command_Nak, 0UL, 0UL);
+			continue;
+		}
+
+		switch(boot_frame.command)
+		{
+			case FRAME_Command_Boot:
+				session = 1;
+				IO_PORT.OUTSET = LED;
+				boot_reply(FRAME_Command_Ack, BOOT_SIZE, BOOT_APPLICATION_SIZE);
+			break;
+
+			case FRAME_Command_Program:
+				// Invalidate the record first, an interrupted update stays in the bootloader
+				if(!programming)
+				{
+					boot_record_write(0U, 0U);
+					programming = 1;
+					valid = 0;
+				}
+
+				if(boot_program())
+				{
+					boot_reply(FRAME_Command_Ack, boot_get_address(boot_frame.payload) + PROGMEM_PAGE_SIZE, 0UL);
+				}
+				else
+				{
+					boot_reply(FRAME_Command_Nak, boot_get_address(boot_frame.payload), 0UL);
+				}
+			break;
+
+			case FRAME_Command_Verify:
+			{
+				unsigned long length = boot_get_address(boot_frame.payload);
+				unsigned int crc = boot_frame.payload[FRAME_ADDRESS_SIZE] | (boot_frame.payload[FRAME_ADDRESS_SIZE + 1] << 8);
+
+				if(	(boot_frame.length == (FRAME_ADDRESS_SIZE + 2)) && length &&
+					(length <= BOOT_APPLICATION_SIZE) && (boot_crc((unsigned int)length) == crc))
+				{
+					boot_record_write((unsigned int)length, crc);
+					programming = 0;
+					valid = 1;
+					boot_reply(FRAME_Command_Ack, length, 0UL);
+				}
+				else
+				{
+					boot_reply(FRAME_Command_Nak, length, 0UL);
+				}
+			}
+			break;
+
+			case FRAME_Command_Run:
+				if(valid)
+				{
+					boot_reply(FRAME_Command_Ack, BOOT_SIZE, 0UL);
+
+					while(!(USART0.STATUS & USART_TXCIF_bm));
+					boot_application();
+				}
+				boot_reply(FRAME_Command_Nak, 0UL, 0UL);
+			break;
+
+			default:
+				boot_reply(FRAME_Command_Nak, 0UL, 0UL);
+			break;
+		}
+
+		// An abandoned session falls back to a valid application
+		deadline = RTC.CNT + BOOT_SESSION_TIMEOUT;
+	}
+}
@@ -0,0 +1,62 @@
+
+#ifndef MAIN_H_
+#define MAIN_H_
+
+	// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+	// !! SETUP FUSES/LINKER        !!
+	// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+	// !! BOOTEND = BOOT_SIZE / 256 !!
+	// !! APPEND  = 0x00            !!
+	// !! Application:              !!
+	// !! -Wl,--section-start=      !!
+	// !!        .text=BOOT_SIZE    !!
+	// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+
+	#ifndef F_CPU
+		#define F_CPU 20000000UL
+	#endif
+
+	#define IO_PORT PORTA
+	#define LED PIN7_bm
+
+	#ifndef BOOT_SIZE
+		#define BOOT_SIZE 0x400U
+	#endif
+
+	#define BOOT_APPLICATION_SIZE (PROGMEM_SIZE - BOOT_SIZE)
+
+	// FT232RL is connected to the alternate USART0 pins (PA1/PA2)
+	#define BOOT_UART_PORT PORTA
+	#define BOOT_UART_TX PIN1_bm
+
+	#ifndef BOOT_BAUDRATE
+		#define BOOT_BAUDRATE 500000UL
+	#endif
+
+	#define BOOT_BAUD_REGISTER ((unsigned int)(((64UL * F_CPU) / (16UL * BOOT_BAUDRATE))))
+
+	// Listen window from reset and idle time of a session (RTC counts, ~ms),
+	// bytes in between do not extend them. Time between frame bytes (ms)
+	#ifndef BOOT_TIMEOUT
+		#define BOOT_TIMEOUT 250U
+	#endif
+
+	#ifndef BOOT_SESSION_TIMEOUT
+		#define BOOT_SESSION_TIMEOUT 2000U
+	#endif
+
+	#define BOOT_BYTE_TIMEOUT 10U
+
+	// Image record (length, CRC16) in the last bytes of the USERROW
+	// 0xFFFF (erased) -> image programmed over UPDI, not verified
+	// 0x0000          -> update in progress, stay in the bootloader
+	#define BOOT_RECORD (USER_SIGNATURES_START + USER_SIGNATURES_SIZE - 4U)
+	#define BOOT_RECORD_ERASED 0xFFFFU
+
+	#include <avr/io.h>
+	#include <util/delay.h>
+	#include <util/crc16.h>
+
+	#include "../lib/utils/frame/frame.h"
+
+#endif /* MAIN_H_ */
@@ -8,7 +8,15 @@ unsigned char EEMEM ee_version = 0x10;
 
 unsigned char EEMEM ee_masterkey[] = "Master Key: ";
 
-SYSTICK_Timer systick_timer;
+// Reserve key (generated on first use) and last used epoch
+unsigned char EEMEM ee_reserve_key[XTEA_KEY_SIZE];
+unsigned long EEMEM ee_reserve_epoch;
+
+// EEMEM variables are placed in order from the start of the EEPROM
+_Static_assert((sizeof(ee_project) + sizeof(ee_creator) + sizeof(ee_copyright) + sizeof(ee_version) +
+				sizeof(ee_masterkey) + sizeof(ee_reserve_key) + sizeof(ee_reserve_epoch)) <= CONFIG_ADDRESS,
+			   "EEMEM variables reach the configuration record");
+
 char buffer[100];
 
 enum BYTE_Nibble_t
@@ -18,9 +26,96 @@ enum BYTE_Nibble_t
 };
 typedef enum BYTE_Nibble_t BYTE_Nibble;
 
+enum APP_State_t
+{
+	APP_State_Locked=0,
+	APP_State_Banner,
+	APP_State_Entry,
+	APP_State_Finished,
+	APP_State_Command,
+	APP_State_Session,
+	APP_State_Generator
+};
+typedef enum APP_State_t APP_State;
+
+enum GENERATOR_Mode_t
+{
+	GENERATOR_Mode_Phrase=0,
+	GENERATOR_Mode_Password
+};
+typedef enum GENERATOR_Mode_t GENERATOR_Mode;
+
+enum RESERVE_State_t
+{
+	RESERVE_State_Mounting=0,
+	RESERVE_State_Ready,
+	RESERVE_State_Overlap
+};
+typedef enum RESERVE_State_t RESERVE_State;
+
+static APP_State app_state = APP_State_Locked;
+
+static CONFIG_Data config;
+
+static unsigned char entry_index = 0;
+static BYTE_Nibble entry_nibble = BYTE_Nibble_High;
+
+static unsigned char trng_pool[TRNG_BUFFER_SIZE];
+static unsigned char trng_pool_available = 0;
+
+static unsigned char rng90_pool[RNG90_OPERATION_RANDOM_RNG_SIZE];
+static unsigned char rng90_pool_available = 0;
+
+static unsigned char command_index = 0;
+
+// Reply frames are only built in a host session, the generator and the
+// record decompression (console commands) only run outside of it
+static union
+{
+	FRAME_Data frame_tx[2];
+	unsigned int generator_indices[WORDLIST_WORDS_MAX];
+	LZSS_Decoder decoder;
+} app_memory;
+static unsigned char frame_tx_index = 0;
+
+static unsigned long transfer_address;
+static unsigned long transfer_end;
+static unsigned char transfer_sequence;
+static unsigned char restore_open = 0;
+
+static WORDLIST_Info wordlist;
+
+// RNG90 serial number as device ID, the vault is bound to it
+static unsigned char device_id[RNG90_OPERATION_READ_SERIAL_SIZE];
+static JOURNAL_Data journal;
+static JOURNAL_Status journal_status;
+static unsigned long journal_mount_time;
+static GENERATOR_Mode generator_mode;
+static unsigned char generator_length;
+static unsigned char generator_index;
+static unsigned char generator_bytes;
+static unsigned int generator_random;
+static unsigned int generator_count;
+static unsigned int generator_done;
+static unsigned long generator_start;
+
+static HEALTH_Data health;
+static unsigned int reserve_rate;
+
+#ifdef RESERVE_EN
+	static RESERVE_Data reserve;
+	static RESERVE_State reserve_state;
+	static unsigned char reserve_chunk[RESERVE_FILL_SIZE];
+	static unsigned char reserve_index;
+	static unsigned char reserve_length;
+	static unsigned int reserve_failures;
+	static unsigned long reserve_page_start;
+#endif
+
 ISR(RTC_CNT_vect)
 {
 	systick_tick();
+	scheduler_tick();
 	RTC.INTFLAGS = RTC_OVF_bm;
 }
 
@@ -46,12 +141,20 @@ void at24cm0x_wp(AT24CM0X_WP_Mode mode)
 	AT24CM0X_PORT_WP.DIRCLR = AT24CM0X_PIN_WP;
 }
 
+static void system_restart(void)
+{
+	CCP = CCP_IOREG_gc;
+	RSTCTRL.SWRR = RSTCTRL_SWRE_bm;
+
+	PORTA.INTFLAGS = PORT_INT_6_bm;
+}
+
 static void trng_start(void)
 {
 	TRNG_PORT.DIRCLR = TRNG_PIN;
 	TRNG_PORT.TRNG_PIN_PINCTRL = TRNG_PIN_SETUP;
-	
-	TCA0.SINGLE.PER = 0x0085;
+
+	TCA0.SINGLE.PER = config.trng_period;
 	TCA0.SINGLE.INTCTRL = TCA_SINGLE_OVF_bm;
 	TCA0.SINGLE.CTRLA = TCA_SINGLE_CLKSEL_DIV1_gc | TCA_SINGLE_ENABLE_bm;
 }
@@ -62,38 +165,10 @@ static void trng_stop(void)
 	TCA0.SINGLE.CTRLA &=  ~TCA_SINGLE_ENABLE_bm;
 }
 
-int main(void)
+static void app_banner(void)
 {
-	system_init();
-	rtc_init();
-	sei();
-	
-	systick_init();
-	uart_init();
-	twi_init();
-	input_init();
-	
-	trng_init();
-	trng_start();
-	trng_stop();
-	
-	rng90_init();
-	
-	at24cm0x_init();
-	
-	PORTA.DIRSET = PIN7_bm;
-
-	while(!input_status(INPUT_SW1))
-	{
-		PORTA.OUTTGL = PIN7_bm;
-		systick_timer_wait_ms(250UL);
-	}
-
-	systick_timer_wait_ms(500UL);
-	PORTA.OUTCLR = PIN7_bm;
-	
 	console_clear();
-	
+
 	eeprom_read_block(buffer, ee_project, sizeof(ee_project));
 	printf("%sVersion: %1u.%1u", buffer, (eeprom_read_byte(&ee_version)>>4), (0x0F & eeprom_read_byte(&ee_version)));
 	console_line(40);
@@ -105,107 +180,1284 @@ int main(void)
 	console_line(40);
 	eeprom_read_block(buffer, ee_masterkey, sizeof(ee_masterkey));
 	printf("%s", buffer);
-	
-	unsigned char i = 0;
-	unsigned char run = 1;
-	
-	BYTE_Nibble nibble = BYTE_Nibble_High;
-	
-	buffer[i] = '\0';
-	
-	do 
+}
+
+static void entry_reset(void)
+{
+	entry_index = 0;
+	entry_nibble = BYTE_Nibble_High;
+	buffer[entry_index] = '\0';
+}
+
+static void entry_next_character(void)
+{
+	uart_putchar('*');
+
+	if(entry_index < (sizeof(buffer) - 1))
+	{
+		entry_index++;
+	}
+	else
+	{
+		app_state = APP_State_Finished;
+	}
+	buffer[entry_index] = '\0';
+}
+
+static void entry_increment(void)
+{
+	if(entry_nibble == BYTE_Nibble_High)
+	{
+		buffer[entry_index] = buffer[entry_index] + 0x10;
+	}
+	else if(entry_nibble == BYTE_Nibble_Low)
+	{
+		buffer[entry_index] = buffer[entry_index] + 0x01;
+	}
+
+	if(	(entry_nibble == BYTE_Nibble_Low) &&
+		((buffer[entry_index] < ' ') ||
+		(buffer[entry_index] > '~')))
 	{
-		if(uart_scanchar(&buffer[i]) == UART_Received)
+		printf("Error -> Restarting\n\r");
+		system_restart();
+	}
+}
+
+static void entry_next_nibble(void)
+{
+	if(entry_nibble == BYTE_Nibble_High)
+	{
+		entry_nibble = BYTE_Nibble_Low;
+	}
+	else
+	{
+		entry_next_character();
+		entry_nibble = BYTE_Nibble_High;
+	}
+}
+
+static unsigned char random_available(void)
+{
+	return (trng_pool_available < rng90_pool_available) ? trng_pool_available : rng90_pool_available;
+}
+
+// Both sources are independent, the XOR is at least as good as the better one
+static unsigned char random_byte(void)
+{
+	return trng_pool[--trng_pool_available] ^ rng90_pool[--rng90_pool_available];
+}
+
+static SCHEDULER_Status task_led(SCHEDULER_Task *task)
+{
+	SCHEDULER_BEGIN(task);
+
+	while(app_state == APP_State_Locked)
+	{
+		IO_PORT.OUTTGL = LED;
+		SCHEDULER_SLEEP(task, 250UL);
+	}
+
+	while(1)
+	{
+		if(	((app_state == APP_State_Entry) && (input_level(INPUT_SW1) || input_level(INPUT_SW2))) ||
+			(app_state == APP_State_Session))
 		{
-			if(buffer[i] == '\n' || buffer[i] == '\r')
-			{
-				break;
-			}
-			uart_putchar('*');
-			i++;
+			IO_PORT.OUTSET = LED;
 		}
-		else if(input_status(INPUT_SW1))
+		else
 		{
-			systick_timer_wait_ms(250UL);
-			
-			if(nibble == BYTE_Nibble_High)
-			{
-				buffer[i] = buffer[i] + 0x10;
-			}
-			else if(nibble == BYTE_Nibble_Low)
-			{
-				buffer[i] = buffer[i] + 0x01;
-			}
-			
-			if(	(nibble == BYTE_Nibble_Low) && 
-				((buffer[i] < ' ') || 
-				(buffer[i] > '~')))
-			{
-				printf("Error -> Restarting\n\r");
-				
-				// Restart System
-				CCP = CCP_IOREG_gc;
-				RSTCTRL.SWRR = RSTCTRL_SWRE_bm;
+			IO_PORT.OUTCLR = LED;
+		}
+		SCHEDULER_SLEEP(task, 10UL);
+	}
+	SCHEDULER_END(task);
+}
 
-				PORTA.INTFLAGS = PORT_INT_6_bm;
-			}
-			
-			while(input_status(INPUT_SW1))
+static SCHEDULER_Status task_input(SCHEDULER_Task *task)
+{
+	SCHEDULER_BEGIN(task);
+
+	if(!(config.flags & CONFIG_FLAG_AUTOSTART))
+	{
+		SCHEDULER_WAIT_UNTIL(task, input_level(INPUT_SW1));
+		SCHEDULER_SLEEP(task, 500UL);
+	}
+
+	app_state = APP_State_Banner;
+
+	// Stream mode skips the entry
+	SCHEDULER_WAIT_UNTIL(task, (app_state == APP_State_Entry) || (app_state == APP_State_Command));
+
+	while(app_state == APP_State_Entry)
+	{
+		SCHEDULER_WAIT_UNTIL(task, (app_state != APP_State_Entry) || input_level(INPUT_SW1) || input_level(INPUT_SW2));
+
+		if(app_state != APP_State_Entry)
+		{
+			break;
+		}
+
+		if(input_level(INPUT_SW1))
+		{
+			SCHEDULER_SLEEP(task, 250UL);
+			entry_increment();
+			SCHEDULER_WAIT_UNTIL(task, !input_level(INPUT_SW1));
+		}
+		else
+		{
+			SCHEDULER_SLEEP(task, 10UL);
+			entry_next_nibble();
+
+			// Holding SW2 for 2s after a complete character finishes the entry
+			task->wakeup = scheduler_ticks() + 2000UL;
+			SCHEDULER_WAIT_UNTIL(task, !input_level(INPUT_SW2) || (scheduler_expired(task->wakeup) && (entry_nibble == BYTE_Nibble_High)));
+
+			if(input_level(INPUT_SW2))
 			{
-				PORTA.OUTSET = PIN7_bm;
+				app_state = APP_State_Finished;
 			}
-			
 		}
-		else if(input_status(INPUT_SW2))
+		SCHEDULER_SLEEP(task, 10UL);
+	}
+
+	// Lock the vault again, SW1 has to be held for 250ms and is ignored
+	// while a frame session or the generator owns the UART
+	while(1)
+	{
+		SCHEDULER_WAIT_UNTIL(task, (app_state == APP_State_Command) && !input_level(INPUT_SW1));
+		SCHEDULER_WAIT_UNTIL(task, input_level(INPUT_SW1));
+		SCHEDULER_SLEEP(task, 250UL);
+
+		if((app_state == APP_State_Command) && input_level(INPUT_SW1))
+		{
+			system_restart();
+		}
+	}
+
+	SCHEDULER_END(task);
+}
+
+static SCHEDULER_Status task_trng(SCHEDULER_Task *task)
+{
+	SCHEDULER_BEGIN(task);
+
+	while(1)
+	{
+		trng_reset();
+		trng_start();
+
+		SCHEDULER_WAIT_UNTIL(task, trng_buffer_status() == TRNG_Buffer_Full);
+
+		trng_stop();
+
 		{
-			systick_timer_wait_ms(10UL);
-			
-			if(nibble == BYTE_Nibble_High)
+			volatile unsigned char *trng_numbers = trng_buffer();
+			unsigned char failed = 0;
+
+			for (unsigned char i=0; i < TRNG_BUFFER_SIZE; i++)
 			{
-				nibble = BYTE_Nibble_Low;
+				trng_pool[i] = *(trng_numbers++);
+
+				if(health_test(&health, trng_pool[i]) != HEALTH_Status_Ok)
+				{
+					failed = 1;
+				}
 			}
-			else
+
+			// A buffer with a failed health test is discarded
+			if(failed)
 			{
-				uart_putchar('*');
-				buffer[(++i)] = '\0';
-				nibble = BYTE_Nibble_High;
+				continue;
 			}
-			
-			systick_timer_set(&systick_timer, 2000UL);
-			
-			while(input_status(INPUT_SW2))
+		}
+		trng_pool_available = TRNG_BUFFER_SIZE;
+
+		SCHEDULER_WAIT_UNTIL(task, trng_pool_available == 0);
+	}
+	SCHEDULER_END(task);
+}
+
+static SCHEDULER_Status task_rng90(SCHEDULER_Task *task)
+{
+	SCHEDULER_BEGIN(task);
+
+	while(1)
+	{
+		SCHEDULER_WAIT_UNTIL(task, !restore_open);
+
+		if(rng90_random(rng90_pool) == RNG90_Status_Success)
+		{
+			rng90_pool_available = RNG90_OPERATION_RANDOM_RNG_SIZE;
+			SCHEDULER_WAIT_UNTIL(task, rng90_pool_available == 0);
+		}
+		else
+		{
+			SCHEDULER_SLEEP(task, 100UL);
+		}
+	}
+	SCHEDULER_END(task);
+}
+
+#ifdef RESERVE_EN
+static unsigned char reserve_overlap(void)
+{
+	return (journal_status != JOURNAL_Status_Invalid) && (journal.end > RESERVE_ADDRESS);
+}
+
+// Filled only while no command or host request waits for random bytes
+static unsigned char reserve_idle(void)
+{
+	return (app_state != APP_State_Session) && (app_state != APP_State_Generator);
+}
+
+static unsigned char reserve_key_valid(const unsigned char *key)
+{
+	unsigned char erased = 0;
+	unsigned char cleared = 0;
+
+	for (unsigned char i=0; i < XTEA_KEY_SIZE; i++)
+	{
+		erased |= (unsigned char)~key[i];
+		cleared |= key[i];
+	}
+	return erased && cleared;
+}
+
+static SCHEDULER_Status task_reserve(SCHEDULER_Task *task)
+{
+	RESERVE_Status status;
+
+	SCHEDULER_BEGIN(task);
+
+	// Vaults formatted before the reserve existed use its pages for records
+	reserve_state = RESERVE_State_Overlap;
+	SCHEDULER_WAIT_UNTIL(task, !reserve_overlap());
+	reserve_state = RESERVE_State_Mounting;
+
+	eeprom_read_block(reserve_chunk, ee_reserve_key, XTEA_KEY_SIZE);
+
+	if(!reserve_key_valid(reserve_chunk))
+	{
+		for (reserve_index = 0; reserve_index < XTEA_KEY_SIZE; reserve_index++)
+		{
+			SCHEDULER_WAIT_UNTIL(task, random_available());
+			reserve_chunk[reserve_index] = random_byte();
+		}
+		eeprom_update_block(reserve_chunk, ee_reserve_key, XTEA_KEY_SIZE);
+	}
+
+	eeprom_update_dword(&ee_reserve_epoch, eeprom_read_dword(&ee_reserve_epoch) + 1UL);
+	reserve_init(&reserve, RESERVE_ADDRESS, RESERVE_PAGES, (const unsigned long *)reserve_chunk, eeprom_read_dword(&ee_reserve_epoch));
+	memset(reserve_chunk, 0, XTEA_KEY_SIZE);
+
+	while(reserve_scan(&reserve) == RESERVE_Status_Busy)
+	{
+		SCHEDULER_YIELD(task);
+	}
+	reserve_state = RESERVE_State_Ready;
+
+	while(1)
+	{
+		SCHEDULER_WAIT_UNTIL(task, reserve_idle() && (reserve.level < reserve.pages));
+
+		if(!reserve.position)
+		{
+			reserve_page_start = scheduler_ticks();
+			reserve_failures = health.rct_failures + health.apt_failures;
+		}
+
+		reserve_length = RESERVE_DATA_SIZE - reserve.position;
+
+		if(reserve_length > RESERVE_FILL_SIZE)
+		{
+			reserve_length = RESERVE_FILL_SIZE;
+		}
+
+		for (reserve_index = 0; reserve_index < reserve_length; reserve_index++)
+		{
+			SCHEDULER_WAIT_UNTIL(task, reserve_idle() && random_available());
+			reserve_chunk[reserve_index] = random_byte();
+		}
+
+		// The page is started over after a failed health test
+		if(reserve_failures != (health.rct_failures + health.apt_failures))
+		{
+			reserve_abandon(&reserve);
+			eeprom_update_dword(&ee_reserve_epoch, reserve.epoch);
+			continue;
+		}
+
+		status = reserve_fill(&reserve, reserve_chunk, reserve_length);
+
+		if(status == RESERVE_Status_Wrapped)
+		{
+			eeprom_update_dword(&ee_reserve_epoch, reserve.epoch);
+			status = reserve_fill(&reserve, reserve_chunk, reserve_length);
+		}
+
+		if(status == RESERVE_Status_Page)
+		{
+			reserve_rate = (unsigned int)((RESERVE_DATA_SIZE * 1000UL) / (scheduler_ticks() - reserve_page_start + 1UL));
+		}
+		SCHEDULER_YIELD(task);
+	}
+	SCHEDULER_END(task);
+}
+#endif
+
+static void frame_reply(FRAME_Command command, unsigned char sequence, unsigned long address)
+{
+	FRAME_Data *frame = &app_memory.frame_tx[frame_tx_index];
+
+	frame->command = command;
+	frame->sequence = sequence;
+	frame->length = FRAME_ADDRESS_SIZE;
+	frame_set_address(frame->payload, address);
+
+	frame_transmit(frame);
+	frame_tx_index ^= 1;
+}
+
+// Prepares the next DATA chunk of the transfer at transfer_address
+static FRAME_Data *frame_data(unsigned int *length)
+{
+	FRAME_Data *frame = &app_memory.frame_tx[frame_tx_index];
+
+	*length = FRAME_CHUNK_SIZE;
+
+	if((transfer_end - transfer_address) < *length)
+	{
+		*length = transfer_end - transfer_address;
+	}
+
+	frame->command = FRAME_Command_Data;
+	frame->sequence = transfer_sequence++;
+	frame->length = FRAME_ADDRESS_SIZE + *length;
+	frame_set_address(frame->payload, transfer_address);
+
+	return frame;
+}
+
+// Status payload:
+// UPTIME (4 bytes, ms) | TRNG POOL | RNG90 POOL | JOURNAL STATUS |
+// RECORDS (2 bytes) | FREE (3 bytes) | DEVICE ID (9 bytes) |
+// RESERVE (3 bytes) | REFILL RATE (2 bytes, B/s) | HEALTH FAILURES (2 bytes)
+static void frame_status(unsigned char *data)
+{
+	unsigned int failures = health.rct_failures + health.apt_failures;
+
+	unsigned long uptime = scheduler_ticks();
+
+	for (unsigned char i=0; i < 4; i++)
+	{
+		data[i] = (unsigned char)(uptime >> (8 * i));
+	}
+	data[4] = trng_pool_available;
+	data[5] = rng90_pool_available;
+	data[6] = journal_status;
+	data[7] = (unsigned char)journal.count;
+	data[8] = (unsigned char)(journal.count >> 8);
+	frame_set_address(&data[9], (journal_status == JOURNAL_Status_Invalid) ? 0UL : (journal.end - journal.head));
+	memcpy(&data[12], device_id, JOURNAL_DEVICE_SIZE);
+#ifdef RESERVE_EN
+	frame_set_address(&data[21], (reserve_state == RESERVE_State_Ready) ? reserve_available(&reserve) : 0UL);
+#else
+	frame_set_address(&data[21], 0UL);
+#endif
+	data[24] = (unsigned char)reserve_rate;
+	data[25] = (unsigned char)(reserve_rate >> 8);
+	data[26] = (unsigned char)failures;
+	data[27] = (unsigned char)(failures >> 8);
+}
+
+// Restore streams every AT24CM02 page in one TWI write: chunks are clocked
+// into the page buffer as they arrive and the page is programmed with one
+// write cycle at the stop condition instead of one per chunk. The bus
+// stays owned meanwhile, the TWI task waits.
+static void restore_close(void)
+{
+	if(restore_open)
+	{
+		twi_stop();
+		restore_open = 0;
+	}
+}
+
+// Returns 0 if the EEPROM does not respond or does not take a byte
+static unsigned char restore_write(unsigned long address, const unsigned char *data, unsigned char length)
+{
+#ifdef AT24CM0X_WP_CONTROL_EN
+	// The driver controls the write protection: one write cycle per chunk
+	return (at24cm0x_write_page(address, (unsigned char *)data, length) == AT24CM0X_Status_Success);
+#else
+	unsigned long timeout;
+
+	if(!restore_open)
+	{
+		timeout = scheduler_ticks() + AT24CM0X_WRITE_TIMEOUT;
+
+		// The previous page may still be programmed
+		while(twi_start() || twi_address(AT24CM0X_DEVICE_ADDRESS | (unsigned char)((address >> 16) & 0x03), TWI_Write))
+		{
+			twi_stop();
+
+			if(scheduler_expired(timeout))
 			{
-				PORTA.OUTSET = PIN7_bm;
-				
-				if(systick_timer_elapsed(&systick_timer) && nibble == BYTE_Nibble_High)
-				{
-					run = 0;
-					break;
-				}
+				return 0;
 			}
 		}
-		PORTA.OUTCLR = PIN7_bm;
-		
-		systick_timer_wait_ms(10UL);
-		
-	} while (run);
-	
-	PORTA.OUTCLR = PIN7_bm;
-	buffer[i] = '\0';
-	
-	console_newline();
-	
-	printf("\n\rPhrase: %s\n\r", buffer);
-	
-	while(1)
+		restore_open = 1;
+
+		if(twi_set((unsigned char)(address >> 8)) || twi_set((unsigned char)address))
+		{
+			restore_close();
+			return 0;
+		}
+	}
+
+	// A NACKed byte ends the page, the host resumes from the last acknowledged address
+	for (unsigned char i=0; i < length; i++)
 	{
-		systick_timer_wait_ms(1000UL);
-		
-		// Restart System
-		CCP = CCP_IOREG_gc;
-		RSTCTRL.SWRR = RSTCTRL_SWRE_bm;
+		if(twi_set(data[i]))
+		{
+			restore_close();
+			return 0;
+		}
+	}
 
-		PORTA.INTFLAGS = PORT_INT_6_bm;
+	if(!((address + length) % VAULT_PAGE_SIZE))
+	{
+		restore_close();
 	}
+	return 1;
+#endif
 }
 
+// Request payload: address (3 bytes) | length (3 bytes)
+static unsigned char frame_transfer_setup(FRAME_Data *request)
+{
+	if(request->length < (2 * FRAME_ADDRESS_SIZE))
+	{
+		return 0;
+	}
+
+	transfer_address = frame_get_address(&request->payload[0]);
+	transfer_end = transfer_address + frame_get_address(&request->payload[FRAME_ADDRESS_SIZE]);
+	transfer_sequence = request->sequence;
+
+	if(transfer_end > VAULT_SIZE)
+	{
+		transfer_end = VAULT_SIZE;
+	}
+	return (transfer_address < transfer_end);
+}
+
+// Dump streams DATA frames: the next chunk is read over TWI while the
+// previous one is still transmitted by the UART interrupt.
+// Restore acknowledges every chunk once it is clocked into the EEPROM page
+// buffer, with two receive buffers the host keeps one chunk in flight.
+// Both transfers are resumable by a new request at the last acknowledged
+// address.
+static SCHEDULER_Status task_frame(SCHEDULER_Task *task)
+{
+	FRAME_Data *request;
+	FRAME_Data *frame;
+	FRAME_Status status;
+	unsigned char sequence;
+	unsigned int length;
+
+	SCHEDULER_BEGIN(task);
+
+	while(1)
+	{
+		SCHEDULER_WAIT_UNTIL(task, app_state == APP_State_Session);
+
+		task->wakeup = scheduler_ticks() + FRAME_SESSION_TIMEOUT;
+		SCHEDULER_WAIT_UNTIL(task, (frame_receive(&request) != FRAME_Status_Empty) || scheduler_expired(task->wakeup));
+
+		status = frame_receive(&request);
+
+		if(status == FRAME_Status_Empty)
+		{
+			frame_receive_stop();
+			app_state = APP_State_Command;
+			printf("> ");
+		}
+		else if(status == FRAME_Status_Corrupt)
+		{
+			sequence = request->sequence;
+			frame_receive_release();
+			frame_reply(FRAME_Command_Nak, sequence, 0UL);
+		}
+		else if((request->command == FRAME_Command_Dump) && frame_transfer_setup(request))
+		{
+			frame_receive_release();
+
+			while(transfer_address < transfer_end)
+			{
+				// Any frame from the host aborts the dump
+				if(frame_receive(&request) != FRAME_Status_Empty)
+				{
+					break;
+				}
+
+				frame = frame_data(&length);
+
+				at24cm0x_read_sequential(transfer_address, &frame->payload[FRAME_ADDRESS_SIZE], length);
+				transfer_address += length;
+
+				SCHEDULER_WAIT_UNTIL(task, !frame_transmit_busy());
+
+				frame_transmit(&app_memory.frame_tx[frame_tx_index]);
+				frame_tx_index ^= 1;
+			}
+			frame_reply(FRAME_Command_Ack, transfer_sequence, transfer_address);
+		}
+#ifdef TWI_TRACE_EN
+		else if(request->command == FRAME_Command_Trace)
+		{
+			transfer_sequence = request->sequence;
+			frame_receive_release();
+
+			// The dump itself is not traced
+			twitrace_enable(0);
+
+			transfer_address = 0UL;
+			transfer_end = twitrace_size();
+
+			while(transfer_address < transfer_end)
+			{
+				frame = frame_data(&length);
+
+				twitrace_read(transfer_address, &frame->payload[FRAME_ADDRESS_SIZE], length);
+				transfer_address += length;
+
+				SCHEDULER_WAIT_UNTIL(task, !frame_transmit_busy());
+
+				frame_transmit(&app_memory.frame_tx[frame_tx_index]);
+				frame_tx_index ^= 1;
+			}
+			frame_reply(FRAME_Command_Ack, transfer_sequence, transfer_address);
+
+			twitrace_clear();
+			twitrace_enable(1);
+		}
+#endif
+		else if((request->command == FRAME_Command_Restore) && frame_transfer_setup(request))
+		{
+			frame_receive_release();
+			frame_reply(FRAME_Command_Ack, transfer_sequence, transfer_address);
+
+			while(transfer_address < transfer_end)
+			{
+				task->wakeup = scheduler_ticks() + FRAME_SESSION_TIMEOUT;
+				SCHEDULER_WAIT_UNTIL(task, (frame_receive(&request) != FRAME_Status_Empty) || scheduler_expired(task->wakeup));
+
+				status = frame_receive(&request);
+
+				// Timeout or a new request from the host ends the restore
+				if(	(status == FRAME_Status_Empty) ||
+					((status == FRAME_Status_Ready) && (request->command != FRAME_Command_Data)))
+				{
+					break;
+				}
+
+				sequence = request->sequence;
+				length = request->length - FRAME_ADDRESS_SIZE;
+
+				if(	(status == FRAME_Status_Ready) &&
+					(request->command == FRAME_Command_Data) &&
+					(request->length > FRAME_ADDRESS_SIZE) &&
+					(frame_get_address(request->payload) == transfer_address) &&
+					((transfer_address + length) <= transfer_end) &&
+					(((transfer_address % VAULT_PAGE_SIZE) + length) <= VAULT_PAGE_SIZE) &&
+					restore_write(transfer_address, &request->payload[FRAME_ADDRESS_SIZE], length))
+				{
+					// Next chunk is received by interrupt meanwhile
+					transfer_address += length;
+
+					// The last page is programmed before its acknowledge
+					if(transfer_address == transfer_end)
+					{
+						restore_close();
+					}
+
+					frame_receive_release();
+					frame_reply(FRAME_Command_Ack, sequence, transfer_address);
+				}
+				else
+				{
+					frame_receive_release();
+					frame_reply(FRAME_Command_Nak, sequence, transfer_address);
+				}
+			}
+			// An aborted restore keeps the acknowledged part of the open page
+			restore_close();
+		}
+		// Single requests (host library), answered with one frame each and
+		// pipelined by the host: the next request is received meanwhile
+		else if((request->command == FRAME_Command_Read) && (request->length == (FRAME_ADDRESS_SIZE + 1)) &&
+				request->payload[FRAME_ADDRESS_SIZE] && (request->payload[FRAME_ADDRESS_SIZE] <= FRAME_CHUNK_SIZE) &&
+				((frame_get_address(request->payload) + request->payload[FRAME_ADDRESS_SIZE]) <= VAULT_SIZE))
+		{
+			transfer_address = frame_get_address(request->payload);
+			transfer_end = transfer_address + request->payload[FRAME_ADDRESS_SIZE];
+			transfer_sequence = request->sequence;
+			frame_receive_release();
+
+			frame = frame_data(&length);
+			at24cm0x_read_sequential(transfer_address, &frame->payload[FRAME_ADDRESS_SIZE], length);
+
+			SCHEDULER_WAIT_UNTIL(task, !frame_transmit_busy());
+
+			frame_transmit(&app_memory.frame_tx[frame_tx_index]);
+			frame_tx_index ^= 1;
+		}
+		else if((request->command == FRAME_Command_Write) && (request->length > FRAME_ADDRESS_SIZE) &&
+				((frame_get_address(request->payload) + request->length - FRAME_ADDRESS_SIZE) <= VAULT_SIZE) &&
+				(((frame_get_address(request->payload) % VAULT_PAGE_SIZE) + request->length - FRAME_ADDRESS_SIZE) <= VAULT_PAGE_SIZE))
+		{
+			sequence = request->sequence;
+			transfer_address = frame_get_address(request->payload);
+			length = request->length - FRAME_ADDRESS_SIZE;
+
+			// A write the EEPROM did not take is retried by the host
+			if(at24cm0x_write_page(transfer_address, &request->payload[FRAME_ADDRESS_SIZE], length) == AT24CM0X_Status_Success)
+			{
+				frame_receive_release();
+				frame_reply(FRAME_Command_Ack, sequence, transfer_address + length);
+			}
+			else
+			{
+				frame_receive_release();
+				frame_reply(FRAME_Command_Nak, sequence, transfer_address);
+			}
+		}
+		else if((request->command == FRAME_Command_Random) && (request->length == 1) &&
+				request->payload[0] && (request->payload[0] <= FRAME_CHUNK_SIZE))
+		{
+			transfer_address = 0UL;
+			transfer_end = request->payload[0];
+			transfer_sequence = request->sequence;
+			frame_receive_release();
+
+			frame_data(&length);
+
+			// Pools are refilled by the TRNG and TWI tasks meanwhile
+			for (; transfer_address < transfer_end; transfer_address++)
+			{
+				SCHEDULER_WAIT_UNTIL(task, random_available());
+				app_memory.frame_tx[frame_tx_index].payload[FRAME_ADDRESS_SIZE + transfer_address] = random_byte();
+			}
+
+			SCHEDULER_WAIT_UNTIL(task, !frame_transmit_busy());
+
+			frame_transmit(&app_memory.frame_tx[frame_tx_index]);
+			frame_tx_index ^= 1;
+		}
+		// Served from the reserve at EEPROM read speed once it is mounted, from the pools otherwise
+		else if((request->command == FRAME_Command_Reserve) && (request->length == 1) &&
+				request->payload[0] && (request->payload[0] <= FRAME_CHUNK_SIZE))
+		{
+			transfer_address = 0UL;
+			transfer_end = request->payload[0];
+			transfer_sequence = request->sequence;
+			frame_receive_release();
+
+			frame = frame_data(&length);
+
+#ifdef RESERVE_EN
+			if((reserve_state == RESERVE_State_Ready) && (reserve_available(&reserve) >= transfer_end))
+			{
+				while(transfer_address < transfer_end)
+				{
+					transfer_address += reserve_read(&reserve, &frame->payload[FRAME_ADDRESS_SIZE + transfer_address], (unsigned char)(transfer_end - transfer_address));
+				}
+			}
+#endif
+
+			for (; transfer_address < transfer_end; transfer_address++)
+			{
+				SCHEDULER_WAIT_UNTIL(task, random_available());
+				app_memory.frame_tx[frame_tx_index].payload[FRAME_ADDRESS_SIZE + transfer_address] = random_byte();
+			}
+
+			SCHEDULER_WAIT_UNTIL(task, !frame_transmit_busy());
+
+			frame_transmit(&app_memory.frame_tx[frame_tx_index]);
+			frame_tx_index ^= 1;
+		}
+		else if(request->command == FRAME_Command_Status)
+		{
+			sequence = request->sequence;
+			frame_receive_release();
+
+			frame = &app_memory.frame_tx[frame_tx_index];
+			frame->command = FRAME_Command_Data;
+			frame->sequence = sequence;
+			frame->length = FRAME_ADDRESS_SIZE + FRAME_STATUS_SIZE;
+			frame_status(&frame->payload[FRAME_ADDRESS_SIZE]);
+			frame_set_address(frame->payload, 0UL);
+
+			SCHEDULER_WAIT_UNTIL(task, !frame_transmit_busy());
+
+			frame_transmit(&app_memory.frame_tx[frame_tx_index]);
+			frame_tx_index ^= 1;
+		}
+		else
+		{
+			sequence = request->sequence;
+			frame_receive_release();
+			frame_reply(FRAME_Command_Nak, sequence, 0UL);
+		}
+	}
+	SCHEDULER_END(task);
+}
+
+static SCHEDULER_Status task_generator(SCHEDULER_Task *task)
+{
+	unsigned char slots[WORDLIST_WORDS_MAX];
+
+	SCHEDULER_BEGIN(task);
+
+	while(1)
+	{
+		SCHEDULER_WAIT_UNTIL(task, app_state == APP_State_Generator);
+
+		generator_start = scheduler_ticks();
+		generator_bytes = 0;
+
+		for (generator_done = 0; generator_done < generator_count; generator_done++)
+		{
+			generator_index = 0;
+
+			while(generator_index < generator_length)
+			{
+				SCHEDULER_WAIT_UNTIL(task, random_available());
+
+				generator_random = (generator_random << 8) | random_byte();
+				generator_bytes++;
+
+				if(generator_mode == GENERATOR_Mode_Phrase)
+				{
+					if(generator_bytes < 2)
+					{
+						continue;
+					}
+
+					if(wordlist_select(&wordlist, generator_random, &app_memory.generator_indices[generator_index]))
+					{
+						generator_index++;
+					}
+				}
+				else if((generator_random & 0xFF) < (256 - (256 % GENERATOR_CHARSET_SIZE)))
+				{
+					buffer[generator_index++] = GENERATOR_CHARSET_FIRST + ((generator_random & 0xFF) % GENERATOR_CHARSET_SIZE);
+				}
+				generator_bytes = 0;
+			}
+
+			if(generator_mode == GENERATOR_Mode_Phrase)
+			{
+				wordlist_read(&wordlist, app_memory.generator_indices, generator_length, buffer, slots);
+
+				for (unsigned char i=0; i < generator_length; i++)
+				{
+					printf("%s%.*s", (i ? " " : ""), wordlist.width, &buffer[slots[i] * wordlist.width]);
+				}
+			}
+			else
+			{
+				buffer[generator_length] = '\0';
+				printf("%s", buffer);
+			}
+			console_newline();
+		}
+
+		printf("%u in %lu ms\n\r> ", generator_count, (scheduler_ticks() - generator_start));
+		app_state = APP_State_Command;
+	}
+	SCHEDULER_END(task);
+}
+
+static void task_report(void);
+
+// phrase <words> [count]
+static void command_phrase(char *arguments)
+{
+	unsigned char words = (unsigned char)strtoul(arguments, &arguments, 10);
+	unsigned char words_max;
+
+	if(wordlist_mount(WORDLIST_ADDRESS, &wordlist) != WORDLIST_Status_Valid)
+	{
+		printf("No wordlist\n\r");
+		return;
+	}
+
+	// Selected words are kept in buffer until they are printed
+	words_max = sizeof(buffer) / wordlist.width;
+
+	if(words_max > WORDLIST_WORDS_MAX)
+	{
+		words_max = WORDLIST_WORDS_MAX;
+	}
+
+	if(!words || (words > words_max))
+	{
+		printf("Words: 1-%u\n\r", words_max);
+		return;
+	}
+
+	generator_mode = GENERATOR_Mode_Phrase;
+	generator_length = words;
+	generator_count = (unsigned int)strtoul(arguments, NULL, 10);
+
+	if(!generator_count)
+	{
+		generator_count = 1;
+	}
+	app_state = APP_State_Generator;
+}
+
+// password <length> [count]
+static void command_password(char *arguments)
+{
+	unsigned char length = (unsigned char)strtoul(arguments, &arguments, 10);
+
+	if(!length || (length >= sizeof(buffer)))
+	{
+		printf("Length: 1-%u\n\r", (unsigned int)(sizeof(buffer) - 1));
+		return;
+	}
+
+	generator_mode = GENERATOR_Mode_Password;
+	generator_length = length;
+	generator_count = (unsigned int)strtoul(arguments, NULL, 10);
+
+	if(!generator_count)
+	{
+		generator_count = 1;
+	}
+	app_state = APP_State_Generator;
+}
+
+static void vault_print(unsigned char data)
+{
+	uart_putchar((char)data);
+}
+
+static void vault_discard(unsigned char data)
+{
+}
+
+static void vault_id(void)
+{
+	for (unsigned char i=0; i < JOURNAL_DEVICE_SIZE; i++)
+	{
+		printf("%02X", device_id[i]);
+	}
+	console_newline();
+}
+
+// Walks the record headers from the nearest checkpoint, a damaged header
+// (or one pointing past the head) stops the walk
+static VAULT_Status vault_record(unsigned int index, unsigned long *address)
+{
+	unsigned int record = journal_checkpoint(&journal, index, address);
+	unsigned int length;
+	unsigned int packed;
+
+	for (; record < index; record++)
+	{
+		if(vault_info(*address, &length, &packed) != VAULT_Status_Valid)
+		{
+			return VAULT_Status_Invalid;
+		}
+		*address += VAULT_HEADER_SIZE + packed;
+
+		if(*address >= journal.head)
+		{
+			return VAULT_Status_Invalid;
+		}
+	}
+	return VAULT_Status_Valid;
+}
+
+// store <text>
+static void command_store(char *arguments)
+{
+	unsigned long start;
+	unsigned int length = strlen(arguments);
+	unsigned int packed;
+
+	if(journal_status != JOURNAL_Status_Valid)
+	{
+		printf("Vault not mounted\n\r");
+		return;
+	}
+
+	if(!length || ((journal.head + VAULT_HEADER_SIZE + length) > journal.end))
+	{
+		printf("Usage: store <text>\n\r");
+		return;
+	}
+
+	start = scheduler_ticks();
+	vault_write(journal.head, (const unsigned char *)arguments, length, &packed);
+	journal_append(&journal, VAULT_HEADER_SIZE + packed);
+
+	printf("Record %u: %u -> %u bytes in %lu ms\n\r", (journal.count - 1), length, packed + VAULT_HEADER_SIZE, (scheduler_ticks() - start));
+}
+
+// load <record>
+static void command_load(char *arguments)
+{
+	unsigned int index = (unsigned int)strtoul(arguments, NULL, 10);
+	unsigned long start = scheduler_ticks();
+	unsigned long address;
+	unsigned int length;
+
+	if((journal_status == JOURNAL_Status_Invalid) || (index >= journal.count))
+	{
+		printf("No record\n\r");
+		return;
+	}
+
+	// Timed without the console, then printed
+	if(	(vault_record(index, &address) != VAULT_Status_Valid) ||
+		(vault_read(address, vault_discard, &length) != VAULT_Status_Valid))
+	{
+		printf("Record %u damaged\n\r", index);
+		return;
+	}
+	start = scheduler_ticks() - start;
+
+	vault_read(address, vault_print, &length);
+	printf("\n\r%u bytes in %lu ms\n\r", length, start);
+}
+
+// format [force], a vault of another device is only overwritten with force
+static void command_format(char *arguments)
+{
+	if((journal_status == JOURNAL_Status_Foreign) && strcmp(arguments, "force"))
+	{
+		printf("Foreign vault, use: format force\n\r");
+		return;
+	}
+
+	journal_status = journal_format(&journal, JOURNAL_ADDRESS, 0UL, RESERVE_ADDRESS, device_id);
+	printf("Vault formatted\n\r");
+}
+
+static void command_id(char *arguments)
+{
+	printf("Device:  ");
+	vault_id();
+
+	if(journal_status == JOURNAL_Status_Invalid)
+	{
+		printf("Vault:   not formatted\n\r");
+		return;
+	}
+
+	printf("Vault:   %u records, %lu bytes free, generation %lu, mounted in %lu ms\n\r", journal.count, (journal.end - journal.head), journal.generation, journal_mount_time);
+
+	if(journal_status == JOURNAL_Status_Foreign)
+	{
+		printf("Foreign: ");
+
+		for (unsigned char i=0; i < JOURNAL_DEVICE_SIZE; i++)
+		{
+			printf("%02X", journal.device[i]);
+		}
+		printf(" (read only)\n\r");
+	}
+}
+
+static void command_reserve(char *arguments)
+{
+#ifndef RESERVE_EN
+	printf("Reserve: off (TWI_TRACE_EN)\n\r");
+#else
+	if(reserve_state == RESERVE_State_Overlap)
+	{
+		printf("Reserve: vault overlaps the reserve, format\n\r");
+	}
+	else if(reserve_state == RESERVE_State_Mounting)
+	{
+		printf("Reserve: mounting\n\r");
+	}
+	else
+	{
+		printf("Reserve: %lu/%lu bytes, %u/%u pages, refill %u B/s, epoch %lu\n\r", reserve_available(&reserve), ((unsigned long)reserve.pages * RESERVE_DATA_SIZE), reserve.level, reserve.pages, reserve_rate, reserve.epoch);
+	}
+#endif
+	printf("Health:  %u repetition, %u proportion failures\n\r", health.rct_failures, health.apt_failures);
+}
+
+static void config_print(CONFIG_Data *config, CONFIG_Status status)
+{
+	printf("Config:    %s, version %u\n\r", ((status == CONFIG_Status_Valid) ? "stored" : "defaults"), CONFIG_VERSION);
+	printf("baud:      %lu\n\r", config->baudrate);
+	printf("per:       %u\n\r", config->trng_period);
+	printf("mode:      %s\n\r", ((config->mode == CONFIG_Mode_Stream) ? "stream" : "console"));
+	printf("autostart: %u\n\r", ((config->flags & CONFIG_FLAG_AUTOSTART) ? 1 : 0));
+	printf("rct:       %u\n\r", config->rct_cutoff);
+	printf("apt:       %u/%u\n\r", config->apt_cutoff, HEALTH_APT_WINDOW);
+}
+
+// config [<field> <value> | default], shows and changes the stored record, active after reset
+static void command_config(char *arguments)
+{
+	char *value = strchr(arguments, ' ');
+	unsigned long number;
+	CONFIG_Data update;
+	CONFIG_Status status = config_load(&update);
+
+	if(!*arguments)
+	{
+		config_print(&update, status);
+		return;
+	}
+
+	if(value)
+	{
+		*(value++) = '\0';
+	}
+	else
+	{
+		value = arguments + strlen(arguments);
+	}
+	number = strtoul(value, NULL, 10);
+
+	if(!strcmp(arguments, "default"))
+	{
+		config_default(&update);
+	}
+	else if(!strcmp(arguments, "baud") && (number >= UART_BAUDRATE_MIN) && (number <= UART_BAUDRATE_MAX))
+	{
+		update.baudrate = number;
+	}
+	else if(!strcmp(arguments, "per") && number && (number <= 0xFFFFUL))
+	{
+		update.trng_period = (unsigned int)number;
+	}
+	else if(!strcmp(arguments, "mode") && (!strcmp(value, "console") || !strcmp(value, "stream")))
+	{
+		update.mode = (value[0] == 's') ? CONFIG_Mode_Stream : CONFIG_Mode_Console;
+	}
+	else if(!strcmp(arguments, "autostart") && (number <= 1UL) && *value)
+	{
+		update.flags = number ? (update.flags | CONFIG_FLAG_AUTOSTART) : (update.flags & ~CONFIG_FLAG_AUTOSTART);
+	}
+	else if(!strcmp(arguments, "rct") && (number >= 2UL) && (number <= 0xFFUL))
+	{
+		update.rct_cutoff = (unsigned char)number;
+	}
+	else if(!strcmp(arguments, "apt") && (number >= 2UL) && (number <= HEALTH_APT_WINDOW))
+	{
+		update.apt_cutoff = (unsigned int)number;
+	}
+	else
+	{
+		printf("Usage: config [baud|per|mode|autostart|rct|apt <value> | default]\n\r");
+		return;
+	}
+
+	config_store(&update);
+
+	printf("Stored, active after reset\n\r");
+}
+
+static void command_stat(char *arguments)
+{
+	task_report();
+}
+
+static void command_mem(char *arguments)
+{
+	printf("SRAM:        %4u bytes\n\r", (unsigned int)INTERNAL_SRAM_SIZE);
+	printf("Static:      %4u bytes\n\r", memory_static());
+	printf("Stack peak:  %4u bytes\n\r", memory_stack_peak());
+	printf("Free:        %4u bytes\n\r", memory_free());
+	printf("Never used:  %4u bytes\n\r", memory_unused());
+}
+
+static void command_reset(char *arguments)
+{
+	system_restart();
+}
+
+static const COMMAND_Entry commands[] =
+{
+	{ "stat", command_stat },
+	{ "mem", command_mem },
+	{ "reset", command_reset },
+	{ "phrase", command_phrase },
+	{ "password", command_password },
+	{ "store", command_store },
+	{ "load", command_load },
+	{ "format", command_format },
+	{ "id", command_id },
+	{ "reserve", command_reserve },
+	{ "config", command_config }
+};
+#define COMMANDS (sizeof(commands)/sizeof(commands[0]))
+
+static SCHEDULER_Status task_console(SCHEDULER_Task *task)
+{
+	char character;
+
+	SCHEDULER_BEGIN(task);
+
+	SCHEDULER_WAIT_UNTIL(task, app_state == APP_State_Banner);
+
+	// Production boards accept frames right after startup
+	if(config.mode == CONFIG_Mode_Stream)
+	{
+		printf("> ");
+	}
+	else
+	{
+		app_banner();
+		entry_reset();
+		app_state = APP_State_Entry;
+
+		while(app_state == APP_State_Entry)
+		{
+			SCHEDULER_WAIT_UNTIL(task, (app_state != APP_State_Entry) || (uart_scanchar(&character) == UART_Received));
+
+			if(app_state != APP_State_Entry)
+			{
+				break;
+			}
+
+			if(character == '\n' || character == '\r')
+			{
+				app_state = APP_State_Finished;
+				break;
+			}
+			buffer[entry_index] = character;
+			entry_next_character();
+		}
+
+		buffer[entry_index] = '\0';
+
+		console_newline();
+
+		printf("\n\rPhrase: %s\n\r> ", buffer);
+	}
+
+	app_state = APP_State_Command;
+
+	while(1)
+	{
+		SCHEDULER_WAIT_UNTIL(task, (app_state == APP_State_Command) && (uart_scanchar(&character) == UART_Received));
+
+		if(character == FRAME_START)
+		{
+			command_index = 0;
+			frame_receive_start(1);
+			app_state = APP_State_Session;
+		}
+		else if(character == '\n' || character == '\r')
+		{
+			buffer[command_index] = '\0';
+			command_index = 0;
+
+			console_newline();
+
+			if(command_execute(commands, COMMANDS, buffer) == COMMAND_Status_Unknown)
+			{
+				printf("Unknown command\n\r");
+			}
+
+			if(app_state == APP_State_Command)
+			{
+				printf("> ");
+			}
+		}
+		else if(command_index < (sizeof(buffer) - 1))
+		{
+			uart_putchar(character);
+			buffer[command_index++] = character;
+		}
+	}
+	SCHEDULER_END(task);
+}
+
+static SCHEDULER_Task tasks[] =
+{
+	SCHEDULER_TASK("LED", task_led),
+	SCHEDULER_TASK("INPUT", task_input),
+	SCHEDULER_TASK("UART", task_console),
+	SCHEDULER_TASK("TRNG", task_trng),
+	SCHEDULER_TASK("TWI", task_rng90),
+	SCHEDULER_TASK("FRAME", task_frame),
+	SCHEDULER_TASK("GEN", task_generator),
+#ifdef RESERVE_EN
+	SCHEDULER_TASK("RSV", task_reserve)
+#endif
+};
+#define TASKS (sizeof(tasks)/sizeof(tasks[0]))
+
+// Largest static buffers of the build, SRAM_STATIC_OTHER is an estimate
+// for the rest (tools/memory.sh checks the linked image, see main.h)
+_Static_assert((sizeof(buffer) + sizeof(app_memory) + FRAME_RX_SRAM + sizeof(trng_pool) + sizeof(rng90_pool) +
+				sizeof(journal) + sizeof(tasks) + VAULT_CHUNK_SIZE + RESERVE_SRAM + TWITRACE_SRAM + SRAM_STATIC_OTHER) <= (RAMSIZE - SRAM_STACK_RESERVE),
+			   "Static SRAM leaves less than SRAM_STACK_RESERVE for the stack");
+
+static void task_report(void)
+{
+	unsigned long elapsed = scheduler_elapsed() / 100UL;
+
+	if(elapsed == 0UL)
+	{
+		elapsed = 1UL;
+	}
+
+	console_line(40);
+
+	for (unsigned char i=0; i < TASKS; i++)
+	{
+		printf("%-6s %8lu runs %3lu%%\n\r", tasks[i].name, tasks[i].runs, (tasks[i].busy / elapsed));
+	}
+}
+
+int main(void)
+{
+	system_init();
+	rtc_init();
+	sei();
+
+	config_load(&config);
+
+	systick_init();
+	uart_init();
+	USART0.BAUD = UART_BAUD_REGISTER(config.baudrate);
+	twi_init();
+	input_init();
+
+	trng_init();
+	rng90_init();
+	health_init(&health, config.rct_cutoff, config.apt_cutoff);
+
+	at24cm0x_init();
+	vault_init(&app_memory.decoder);
+
+	rng90_serial(device_id);
+
+	journal_mount_time = scheduler_ticks();
+	journal_status = journal_mount(&journal, JOURNAL_ADDRESS, device_id);
+	journal_mount_time = scheduler_ticks() - journal_mount_time;
+
+	IO_PORT.DIRSET = LED;
+
+	scheduler_reset(tasks, TASKS);
+
+	while(1)
+	{
+		scheduler_run(tasks, TASKS);
+	}
+}
@@ -7,6 +7,8 @@
 	// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
 	// !! UART_RXC_ECHO             !!
 	// !! AT24CM0X_WP_CONTROL_EN    !!
+	// !! TWI_TRACE_EN              !!
+	// !! VAULT_LZSS_EN             !!
 	// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
 
 	#ifndef F_CPU
@@ -29,7 +31,76 @@
 	#define AT24CM0X_PORT_WP PORTB
 	#define AT24CM0X_PIN_WP PIN2_bm
 
+	#define VAULT_SIZE 0x40000UL
+	#define VAULT_PAGE_SIZE 256UL
+
+	// AT24CM02 memory map
+	// 0x00000 - 0x23FFF: Vault records
+	// 0x24000 - 0x2BCFF: Entropy reserve (125 pages, 31000 bytes)
+	// 0x2BD00 - 0x2BFFF: Journal (superblock, slot A, slot B)
+	// 0x2C000 - 0x3FFFF: Wordlist (e.g. EFF large wordlist, 7776 x 10 bytes)
+	#define RESERVE_ADDRESS 0x24000UL
+	#define RESERVE_PAGES 125U
+	#define JOURNAL_ADDRESS 0x2BD00UL
+	#define WORDLIST_ADDRESS 0x2C000UL
+
+	// Random bytes collected per reserve write
+	#ifndef RESERVE_FILL_SIZE
+		#define RESERVE_FILL_SIZE 32U
+	#endif
+
+	#ifndef GENERATOR_CHARSET_FIRST
+		#define GENERATOR_CHARSET_FIRST '!'
+		#define GENERATOR_CHARSET_SIZE 94
+	#endif
+
+	#define FRAME_STATUS_SIZE 28
+
+	// USART0 in normal mode, BAUD >= 64
+	#define UART_BAUD_REGISTER(baudrate) ((unsigned int)((64UL * F_CPU) / (16UL * (baudrate))))
+	#define UART_BAUDRATE_MIN CONFIG_BAUDRATE_MIN
+	#define UART_BAUDRATE_MAX CONFIG_BAUDRATE_MAX
+
+	#ifndef FRAME_SESSION_TIMEOUT
+		#define FRAME_SESSION_TIMEOUT 1000UL
+	#endif
+
+	// AT24CM02 TWI address (A2 high), A17/A16 are added per page
+	#ifndef AT24CM0X_DEVICE_ADDRESS
+		#define AT24CM0X_DEVICE_ADDRESS 0x54
+	#endif
+
+	// Acknowledge polling after a page write (tWR 10 ms max)
+	#ifndef AT24CM0X_WRITE_TIMEOUT
+		#define AT24CM0X_WRITE_TIMEOUT 20UL
+	#endif
+
+	// The reserve refills whenever the board is idle, its TWI traffic would
+	// flood the trace ring. Trace builds leave it out, which also makes
+	// room for the ring in the SRAM.
+	#ifndef TWI_TRACE_EN
+		#define RESERVE_EN
+	#endif
+
+	// Static SRAM budget, at least SRAM_STACK_RESERVE bytes stay free for
+	// the stack (printf and interrupts included)
+	#ifndef SRAM_STACK_RESERVE
+		#define SRAM_STACK_RESERVE 128U
+	#endif
+
+	// Small variables, stdio and HAL state next to the checked buffers.
+	// Estimated from their declarations with AVR type sizes, not taken from
+	// a linked image: the compile-time check only catches a buffer that
+	// outgrows the budget. tools/memory.sh checks .data, .bss and .noinit of
+	// the linked image against SRAM_STACK_RESERVE and is the authority. To
+	// recalibrate: static size printed by memory.sh minus the buffers
+	// summed in the _Static_assert of main.c.
+	#ifndef SRAM_STATIC_OTHER
+		#define SRAM_STATIC_OTHER 144U
+	#endif
+
 	#include <string.h>
+	#include <stdlib.h>
 	#include <avr/io.h>
 	#include <avr/eeprom.h>
 	#include <avr/interrupt.h>
@@ -46,5 +117,43 @@
 	
 	#include "../lib/utils/systick/systick.h"
 	#include "../lib/utils/console/console.h"
+	#include "../lib/utils/scheduler/scheduler.h"
+	#include "../lib/utils/frame/frame.h"
+	#include "../lib/utils/command/command.h"
+	#include "../lib/utils/wordlist/wordlist.h"
+	#include "../lib/utils/twitrace/twitrace.h"
+	#include "../lib/utils/vault/vault.h"
+	#include "../lib/utils/journal/journal.h"
+	#include "../lib/utils/memory/memory.h"
+	#include "../lib/utils/health/health.h"
+	#include "../lib/utils/reserve/reserve.h"
+	#include "../lib/utils/config/config.h"
+
+	#if JOURNAL_DEVICE_SIZE != RNG90_OPERATION_READ_SERIAL_SIZE
+		#error "Journal device ID has to hold the RNG90 serial number"
+	#endif
+
+	#if (RESERVE_ADDRESS + (RESERVE_PAGES * RESERVE_PAGE_SIZE)) > JOURNAL_ADDRESS
+		#error "Entropy reserve overlaps the journal"
+	#endif
+
+	#if RESERVE_FILL_SIZE < XTEA_KEY_SIZE
+		#error "RESERVE_FILL_SIZE has to hold the reserve key"
+	#endif
+
+	// Static buffers outside of main.c
+	#define FRAME_RX_SRAM (2U * sizeof(FRAME_Data))
+
+	#ifdef RESERVE_EN
+		#define RESERVE_SRAM (sizeof(RESERVE_Data) + RESERVE_FILL_SIZE)
+	#else
+		#define RESERVE_SRAM 0U
+	#endif
+
+	#ifdef TWI_TRACE_EN
+		#define TWITRACE_SRAM (TWITRACE_SIZE * sizeof(TWITRACE_Record))
+	#else
+		#define TWITRACE_SRAM 0U
+	#endif
 	
 #endif /* MAIN_H_ */
\ No newline at end of file
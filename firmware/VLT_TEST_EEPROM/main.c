@@ -155,6 +155,8 @@ int main(void)
 		printf("0x%02hhx, ", temp);
 	}
 	
+	printf("\n\rStack peak: %u bytes, never used: %u bytes\n\r", memory_stack_peak(), memory_unused());
+	
 	while (1)
 	{
 		printf("\n\rReset Buffer:\n\r");
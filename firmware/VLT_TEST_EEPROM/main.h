@@ -36,5 +36,6 @@
 
 	#include "../lib/drivers/prom/at24cm0x/at24cm0x.h"
 	#include "../lib/utils/systick/systick.h"
+	#include "../lib/utils/memory/memory.h"
 	
 #endif /* MAIN_H_ */
\ No newline at end of file
@@ -73,8 +73,15 @@ int main(void)
 	printf("Done\n\r");
 	
 	unsigned int per = 0UL;
+	CONFIG_Data config;
 	
-	do 
+	// Stored TRNG period of VLT_FW_1_0, asked for without a valid record
+	if(config_load(&config) == CONFIG_Status_Valid)
+	{
+		per = config.trng_period;
+	}
+	
+	while (per == 0UL)
 	{
 		printf("PER->[1-65535]: ");
 		
@@ -85,7 +92,7 @@ int main(void)
 			continue;
 		}
 		printf("\n\r");
-	} while (per == 0UL);
+	}
 	
 	TCA0.SINGLE.PER = per;
 	
@@ -29,6 +29,7 @@
 	#include <string.h>
 	#include <avr/io.h>
 	#include <avr/interrupt.h>
+	#include <avr/eeprom.h>
 	#include <util/delay.h>
 
 	#include "../lib/hal/common/macros/PORT_macros.h"
@@ -39,5 +40,6 @@
 	
 	#include "../lib/drivers/crypto/trng/trng.h"
 	#include "../lib/utils/systick/systick.h"
+	#include "../lib/utils/config/config.h"
 	
 #endif /* MAIN_H_ */
\ No newline at end of file
@@ -16,4 +16,14 @@ INPUT_Status input_status(INPUT_Name name)
         return INPUT_Status_ON;
     }
     return INPUT_Status_OFF;
+}
+
+// Non blocking, debouncing is up to the caller
+INPUT_Status input_level(INPUT_Name name)
+{
+    if(!(INPUT_PORT.IN & name))
+    {
+        return INPUT_Status_ON;
+    }
+    return INPUT_Status_OFF;
 }
\ No newline at end of file
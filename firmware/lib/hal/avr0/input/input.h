@@ -47,5 +47,6 @@
 
     void input_init(void);
     INPUT_Status input_status(INPUT_Name name);
+    INPUT_Status input_level(INPUT_Name name);
 
 #endif /* INPUT_H_ */
\ No newline at end of file
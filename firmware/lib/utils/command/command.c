@@ -0,0 +1,39 @@
+
+#include "command.h"
+
+// Splits "name arguments" and calls the matching handler of the table
+COMMAND_Status command_execute(const COMMAND_Entry *commands, unsigned char count, char *line)
+{
+    char *arguments;
+
+    while(*line == COMMAND_SEPARATOR)
+    {
+        line++;
+    }
+
+    if(*line == '\0')
+    {
+        return COMMAND_Status_Empty;
+    }
+
+    arguments = strchr(line, COMMAND_SEPARATOR);
+
+    if(arguments)
+    {
+        *(arguments++) = '\0';
+    }
+    else
+    {
+        arguments = line + strlen(line);
+    }
+
+    for (unsigned char i=0; i < count; i++)
+    {
+        if(!strcmp(line, commands[i].name))
+        {
+            commands[i].handler(arguments);
+            return COMMAND_Status_Executed;
+        }
+    }
+    return COMMAND_Status_Unknown;
+}
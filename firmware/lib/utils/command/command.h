@@ -0,0 +1,29 @@
+
+#ifndef COMMAND_H_
+#define COMMAND_H_
+
+    #ifndef COMMAND_SEPARATOR
+        #define COMMAND_SEPARATOR ' '
+    #endif
+
+    #include <string.h>
+
+    typedef void (*COMMAND_Handler)(char *arguments);
+
+    typedef struct
+    {
+        const char *name;
+        COMMAND_Handler handler;
+    } COMMAND_Entry;
+
+    enum COMMAND_Status_t
+    {
+        COMMAND_Status_Executed=0,
+        COMMAND_Status_Empty,
+        COMMAND_Status_Unknown
+    };
+    typedef enum COMMAND_Status_t COMMAND_Status;
+
+    COMMAND_Status command_execute(const COMMAND_Entry *commands, unsigned char count, char *line);
+
+#endif /* COMMAND_H_ */
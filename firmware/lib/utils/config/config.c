@@ -0,0 +1,81 @@
+
+#include "config.h"
+
+static unsigned int config_crc(const unsigned char *data)
+{
+    unsigned int crc = 0;
+
+    for (unsigned char i=0; i < (CONFIG_SIZE - 2); i++)
+    {
+        crc = _crc_xmodem_update(crc, data[i]);
+    }
+    return crc;
+}
+
+void config_default(CONFIG_Data *config)
+{
+    config->baudrate = CONFIG_BAUDRATE;
+    config->trng_period = CONFIG_TRNG_PERIOD;
+    config->mode = CONFIG_Mode_Console;
+    config->flags = 0;
+    config->rct_cutoff = HEALTH_RCT_CUTOFF;
+    config->apt_cutoff = HEALTH_APT_CUTOFF;
+}
+
+CONFIG_Status config_load(CONFIG_Data *config)
+{
+    unsigned char data[CONFIG_SIZE];
+
+    eeprom_read_block(data, (const void *)CONFIG_ADDRESS, CONFIG_SIZE);
+
+    if(	(data[0] != CONFIG_VERSION) ||
+        (config_crc(data) != (unsigned int)(data[CONFIG_SIZE - 2] | (data[CONFIG_SIZE - 1] << 8))))
+    {
+        config_default(config);
+        return CONFIG_Status_Default;
+    }
+
+    config->baudrate = (unsigned long)data[1] | ((unsigned long)data[2] << 8) | ((unsigned long)data[3] << 16) | ((unsigned long)data[4] << 24);
+    config->trng_period = data[5] | (data[6] << 8);
+    config->mode = (CONFIG_Mode)data[7];
+    config->flags = data[8];
+    config->rct_cutoff = data[9];
+    config->apt_cutoff = data[10] | (data[11] << 8);
+
+    // An invalid baudrate or period would stop the board before the record
+    // can be fixed, cutoffs below 2 would disable the health tests
+    if(	(config->baudrate < CONFIG_BAUDRATE_MIN) || (config->baudrate > CONFIG_BAUDRATE_MAX) ||
+        !config->trng_period || (config->mode > CONFIG_Mode_Stream) ||
+        (config->rct_cutoff < 2) || (config->apt_cutoff < 2) || (config->apt_cutoff > HEALTH_APT_WINDOW))
+    {
+        config_default(config);
+        return CONFIG_Status_Default;
+    }
+    return CONFIG_Status_Valid;
+}
+
+// Unchanged bytes are not rewritten (EEPROM endurance)
+void config_store(const CONFIG_Data *config)
+{
+    unsigned char data[CONFIG_SIZE];
+    unsigned int crc;
+
+    data[0] = CONFIG_VERSION;
+    data[1] = (unsigned char)config->baudrate;
+    data[2] = (unsigned char)(config->baudrate >> 8);
+    data[3] = (unsigned char)(config->baudrate >> 16);
+    data[4] = (unsigned char)(config->baudrate >> 24);
+    data[5] = (unsigned char)config->trng_period;
+    data[6] = (unsigned char)(config->trng_period >> 8);
+    data[7] = (unsigned char)config->mode;
+    data[8] = config->flags;
+    data[9] = config->rct_cutoff;
+    data[10] = (unsigned char)config->apt_cutoff;
+    data[11] = (unsigned char)(config->apt_cutoff >> 8);
+
+    crc = config_crc(data);
+    data[12] = (unsigned char)crc;
+    data[13] = (unsigned char)(crc >> 8);
+
+    eeprom_update_block(data, (void *)CONFIG_ADDRESS, CONFIG_SIZE);
+}
@@ -0,0 +1,73 @@
+
+#ifndef CONFIG_H_
+#define CONFIG_H_
+
+    // Device configuration in the last bytes of the internal EEPROM, at a
+    // fixed address so every project (firmware and tests) finds it:
+    // VERSION | BAUDRATE (4) | TRNG PERIOD (2) | MODE | FLAGS |
+    // RCT CUTOFF | APT CUTOFF (2) | CRC16
+    // All multi byte values LSB first, CRC16 is CRC-XMODEM of the preceding
+    // bytes. An erased or corrupt record, an unknown VERSION or a value the
+    // config command would not accept loads the defaults, EEMEM variables
+    // must not reach CONFIG_ADDRESS.
+
+    #define CONFIG_VERSION 1
+    #define CONFIG_SIZE 14
+
+    #ifndef CONFIG_ADDRESS
+        #define CONFIG_ADDRESS (EEPROM_SIZE - CONFIG_SIZE)
+    #endif
+
+    #ifndef CONFIG_BAUDRATE
+        #define CONFIG_BAUDRATE 115200UL
+    #endif
+
+    #ifndef F_CPU
+        #define F_CPU 20000000UL
+    #endif
+
+    // USART0 in normal mode, BAUD >= 64
+    #define CONFIG_BAUDRATE_MIN (((4UL * F_CPU) / 65535UL) + 1UL)
+    #define CONFIG_BAUDRATE_MAX (F_CPU / 16UL)
+
+    #ifndef CONFIG_TRNG_PERIOD
+        #define CONFIG_TRNG_PERIOD 0x0085
+    #endif
+
+    #define CONFIG_FLAG_AUTOSTART 0x01
+
+    #include <avr/io.h>
+    #include <avr/eeprom.h>
+    #include <util/crc16.h>
+
+    #include "../health/health.h"
+
+    enum CONFIG_Mode_t
+    {
+        CONFIG_Mode_Console=0,
+        CONFIG_Mode_Stream
+    };
+    typedef enum CONFIG_Mode_t CONFIG_Mode;
+
+    enum CONFIG_Status_t
+    {
+        CONFIG_Status_Valid=0,
+        CONFIG_Status_Default
+    };
+    typedef enum CONFIG_Status_t CONFIG_Status;
+
+    typedef struct
+    {
+        unsigned long baudrate;
+        unsigned int trng_period;
+        CONFIG_Mode mode;
+        unsigned char flags;
+        unsigned char rct_cutoff;
+        unsigned int apt_cutoff;
+    } CONFIG_Data;
+
+    void config_default(CONFIG_Data *config);
+    CONFIG_Status config_load(CONFIG_Data *config);
+    void config_store(const CONFIG_Data *config);
+
+#endif /* CONFIG_H_ */
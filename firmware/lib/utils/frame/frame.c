@@ -0,0 +1,150 @@
+
+#include "frame.h"
+
+static const unsigned char *volatile frame_tx_data;
+static volatile unsigned char frame_tx_remaining = 0;
+
+// Double buffered reception: one frame is processed while the next arrives
+static FRAME_Data frame_rx[2];
+static volatile FRAME_Status frame_rx_status[2];
+static volatile unsigned char frame_rx_write = 0;
+static unsigned char frame_rx_read = 0;
+static volatile unsigned char frame_rx_index = 0;
+static volatile unsigned int frame_rx_crc = 0;
+
+ISR(USART0_DRE_vect)
+{
+    USART0.TXDATAL = *frame_tx_data++;
+
+    if(!(--frame_tx_remaining))
+    {
+        USART0.CTRLA &= ~USART_DREIE_bm;
+    }
+}
+
+ISR(USART0_RXC_vect)
+{
+    unsigned char data = USART0.RXDATAL;
+    unsigned char index = frame_rx_index;
+    FRAME_Data *frame = &frame_rx[frame_rx_write];
+
+    // Both buffers occupied -> drop, the host resends on timeout
+    if(frame_rx_status[frame_rx_write] != FRAME_Status_Empty)
+    {
+        return;
+    }
+
+    if(index == 0)
+    {
+        if(data == FRAME_START)
+        {
+            frame->start = data;
+            frame_rx_crc = 0;
+            frame_rx_index = 1;
+        }
+        return;
+    }
+
+    if((index == (FRAME_HEADER_SIZE - 1)) && (data > FRAME_PAYLOAD_SIZE))
+    {
+        frame_rx_index = 0;
+        return;
+    }
+
+    ((unsigned char *)frame)[index++] = data;
+
+    if(index <= (FRAME_HEADER_SIZE + frame->length))
+    {
+        frame_rx_crc = _crc_xmodem_update(frame_rx_crc, data);
+    }
+    else if(index == (FRAME_HEADER_SIZE + frame->length + FRAME_CRC_SIZE))
+    {
+        unsigned int crc = frame->payload[frame->length] | (frame->payload[frame->length + 1] << 8);
+
+        frame_rx_status[frame_rx_write] = (crc == frame_rx_crc) ? FRAME_Status_Ready : FRAME_Status_Corrupt;
+        frame_rx_write ^= 1;
+        index = 0;
+    }
+    frame_rx_index = index;
+}
+
+void frame_transmit(FRAME_Data *frame)
+{
+    unsigned int crc = 0;
+    unsigned char *data = &frame->command;
+
+    while(frame_transmit_busy());
+
+    frame->start = FRAME_START;
+
+    for (unsigned char i=0; i < (FRAME_HEADER_SIZE - 1 + frame->length); i++)
+    {
+        crc = _crc_xmodem_update(crc, *(data++));
+    }
+    frame->payload[frame->length] = (unsigned char)crc;
+    frame->payload[frame->length + 1] = (unsigned char)(crc >> 8);
+
+    frame_tx_data = &frame->start;
+    frame_tx_remaining = FRAME_HEADER_SIZE + frame->length + FRAME_CRC_SIZE;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        USART0.CTRLA |= USART_DREIE_bm;
+    }
+}
+
+unsigned char frame_transmit_busy(void)
+{
+    return (frame_tx_remaining != 0);
+}
+
+// started: START byte has already been consumed by the (polled) caller
+void frame_receive_start(unsigned char started)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        frame_rx_status[0] = FRAME_Status_Empty;
+        frame_rx_status[1] = FRAME_Status_Empty;
+        frame_rx_write = 0;
+        frame_rx_read = 0;
+        frame_rx_crc = 0;
+        frame_rx_index = started ? 1 : 0;
+        frame_rx[0].start = FRAME_START;
+
+        USART0.CTRLA |= USART_RXCIE_bm;
+    }
+}
+
+void frame_receive_stop(void)
+{
+    while(frame_transmit_busy());
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        USART0.CTRLA &= ~USART_RXCIE_bm;
+    }
+}
+
+FRAME_Status frame_receive(FRAME_Data **frame)
+{
+    *frame = &frame_rx[frame_rx_read];
+    return frame_rx_status[frame_rx_read];
+}
+
+void frame_receive_release(void)
+{
+    frame_rx_status[frame_rx_read] = FRAME_Status_Empty;
+    frame_rx_read ^= 1;
+}
+
+unsigned long frame_get_address(const unsigned char *data)
+{
+    return (unsigned long)data[0] | ((unsigned long)data[1] << 8) | ((unsigned long)data[2] << 16);
+}
+
+void frame_set_address(unsigned char *data, unsigned long address)
+{
+    data[0] = (unsigned char)address;
+    data[1] = (unsigned char)(address >> 8);
+    data[2] = (unsigned char)(address >> 16);
+}
@@ -0,0 +1,83 @@
+
+#ifndef FRAME_H_
+#define FRAME_H_
+
+    // Binary frame:
+    // START | COMMAND | SEQUENCE | LENGTH | PAYLOAD[LENGTH] | CRC16 (LSB first)
+    // CRC16 is CRC-XMODEM (0x1021, init 0x0000) over COMMAND..PAYLOAD.
+    //
+    // Transmission and reception are interrupt driven (USART0 DRE/RXC), so
+    // the caller can prepare the next frame (e.g. a TWI transfer) while the
+    // current one is on the wire. The uart library stays polled and must
+    // not be used while a frame is transmitted.
+
+    #ifndef FRAME_START
+        #define FRAME_START 0x02
+    #endif
+
+    #ifndef FRAME_CHUNK_SIZE
+        #define FRAME_CHUNK_SIZE 64
+    #endif
+
+    #ifndef FRAME_PAYLOAD_SIZE
+        #define FRAME_PAYLOAD_SIZE (FRAME_ADDRESS_SIZE + FRAME_CHUNK_SIZE)
+    #endif
+
+    #define FRAME_ADDRESS_SIZE 3
+    #define FRAME_HEADER_SIZE 4
+    #define FRAME_CRC_SIZE 2
+
+    #include <avr/io.h>
+    #include <avr/interrupt.h>
+    #include <util/atomic.h>
+    #include <util/crc16.h>
+
+    enum FRAME_Command_t
+    {
+        FRAME_Command_Ack=0x01,
+        FRAME_Command_Nak=0x02,
+        FRAME_Command_Dump=0x10,
+        FRAME_Command_Restore=0x11,
+        FRAME_Command_Data=0x12,
+        FRAME_Command_Read=0x13,
+        FRAME_Command_Write=0x14,
+        FRAME_Command_Random=0x15,
+        FRAME_Command_Status=0x16,
+        FRAME_Command_Reserve=0x17,
+        FRAME_Command_Trace=0x20,
+        FRAME_Command_Boot=0x30,
+        FRAME_Command_Program=0x31,
+        FRAME_Command_Verify=0x32,
+        FRAME_Command_Run=0x33
+    };
+    typedef enum FRAME_Command_t FRAME_Command;
+
+    enum FRAME_Status_t
+    {
+        FRAME_Status_Empty=0,
+        FRAME_Status_Ready,
+        FRAME_Status_Corrupt
+    };
+    typedef enum FRAME_Status_t FRAME_Status;
+
+    typedef struct
+    {
+        unsigned char start;
+        unsigned char command;
+        unsigned char sequence;
+        unsigned char length;
+        unsigned char payload[FRAME_PAYLOAD_SIZE + FRAME_CRC_SIZE];
+    } FRAME_Data;
+
+    void frame_transmit(FRAME_Data *frame);
+    unsigned char frame_transmit_busy(void);
+
+    void frame_receive_start(unsigned char started);
+    void frame_receive_stop(void);
+    FRAME_Status frame_receive(FRAME_Data **frame);
+    void frame_receive_release(void);
+
+    unsigned long frame_get_address(const unsigned char *data);
+    void frame_set_address(unsigned char *data, unsigned long address);
+
+#endif /* FRAME_H_ */
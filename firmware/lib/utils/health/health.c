@@ -0,0 +1,50 @@
+
+#include "health.h"
+
+void health_init(HEALTH_Data *health, unsigned char rct_cutoff, unsigned int apt_cutoff)
+{
+    health->rct_cutoff = rct_cutoff;
+    health->apt_cutoff = apt_cutoff;
+    health->rct_count = 0;
+    health->apt_index = 0;
+    health->rct_failures = 0;
+    health->apt_failures = 0;
+}
+
+HEALTH_Status health_test(HEALTH_Data *health, unsigned char sample)
+{
+    HEALTH_Status status = HEALTH_Status_Ok;
+
+    if(health->rct_count && (sample == health->rct_sample))
+    {
+        if(++health->rct_count >= health->rct_cutoff)
+        {
+            // Counted once per run, the next sample starts a new one
+            health->rct_count = 0;
+            health->rct_failures++;
+            status = HEALTH_Status_Repetition;
+        }
+    }
+    else
+    {
+        health->rct_sample = sample;
+        health->rct_count = 1;
+    }
+
+    if(!health->apt_index)
+    {
+        health->apt_sample = sample;
+        health->apt_count = 1;
+    }
+    else if((sample == health->apt_sample) && (++health->apt_count == health->apt_cutoff))
+    {
+        health->apt_failures++;
+        status = HEALTH_Status_Proportion;
+    }
+
+    if(++health->apt_index >= HEALTH_APT_WINDOW)
+    {
+        health->apt_index = 0;
+    }
+    return status;
+}
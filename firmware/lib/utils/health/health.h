@@ -0,0 +1,50 @@
+
+#ifndef HEALTH_H_
+#define HEALTH_H_
+
+    // Continuous health tests of a noise source (NIST SP 800-90B, 4.4)
+    // Repetition count test: RCT_CUTOFF identical samples in a row fail.
+    // Adaptive proportion test: the first sample of every window of
+    // HEALTH_APT_WINDOW samples must not occur APT_CUTOFF times in it.
+    // Cutoffs follow from the claimed entropy H per sample and the false
+    // positive rate alpha: RCT = 1 + ceil(-log2(alpha) / H),
+    // APT = 1 + binomial quantile (W, 2^-H, 1 - alpha).
+    // The defaults claim H = 2 bits per byte with alpha = 2^-20.
+
+    #ifndef HEALTH_APT_WINDOW
+        #define HEALTH_APT_WINDOW 512U
+    #endif
+
+    #ifndef HEALTH_RCT_CUTOFF
+        #define HEALTH_RCT_CUTOFF 11U
+    #endif
+
+    #ifndef HEALTH_APT_CUTOFF
+        #define HEALTH_APT_CUTOFF 177U
+    #endif
+
+    enum HEALTH_Status_t
+    {
+        HEALTH_Status_Ok=0,
+        HEALTH_Status_Repetition,
+        HEALTH_Status_Proportion
+    };
+    typedef enum HEALTH_Status_t HEALTH_Status;
+
+    typedef struct
+    {
+        unsigned char rct_cutoff;
+        unsigned int apt_cutoff;
+        unsigned char rct_sample;
+        unsigned char rct_count;
+        unsigned char apt_sample;
+        unsigned int apt_count;
+        unsigned int apt_index;
+        unsigned int rct_failures;
+        unsigned int apt_failures;
+    } HEALTH_Data;
+
+    void health_init(HEALTH_Data *health, unsigned char rct_cutoff, unsigned int apt_cutoff);
+    HEALTH_Status health_test(HEALTH_Data *health, unsigned char sample);
+
+#endif /* HEALTH_H_ */
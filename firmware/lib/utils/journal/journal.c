@@ -0,0 +1,237 @@
+
+#include "journal.h"
+
+#define JOURNAL_CHECKPOINT_OFFSET 16
+
+static void journal_set(unsigned char *data, unsigned long value, unsigned char size)
+{
+    for (unsigned char i=0; i < size; i++)
+    {
+        data[i] = (unsigned char)value;
+        value >>= 8;
+    }
+}
+
+static unsigned long journal_get(const unsigned char *data, unsigned char size)
+{
+    unsigned long value = 0UL;
+
+    while(size--)
+    {
+        value = (value << 8) | data[size];
+    }
+    return value;
+}
+
+static unsigned int journal_crc(const unsigned char *data, unsigned char length)
+{
+    unsigned int crc = 0;
+
+    for (unsigned char i=0; i < length; i++)
+    {
+        crc = _crc_xmodem_update(crc, data[i]);
+    }
+    return crc;
+}
+
+static void journal_seal(unsigned char *data, unsigned char magic, unsigned char length)
+{
+    data[0] = 'V';
+    data[1] = magic;
+    data[2] = JOURNAL_VERSION;
+    data[3] = 0x00;
+
+    journal_set(&data[length - 2], journal_crc(data, length - 2), 2);
+}
+
+static unsigned char journal_valid(const unsigned char *data, unsigned char magic, unsigned char length)
+{
+    return (data[0] == 'V') && (data[1] == magic) && (data[2] == JOURNAL_VERSION) &&
+           (journal_crc(data, length - 2) == journal_get(&data[length - 2], 2));
+}
+
+static unsigned long journal_slot(const JOURNAL_Data *journal, unsigned char slot)
+{
+    return journal->address + ((1UL + slot) * JOURNAL_PAGE_SIZE);
+}
+
+// Records between two checkpoints for count records, doubled whenever the
+// checkpoints would not cover the records any more
+static unsigned int journal_stride(unsigned int count)
+{
+    unsigned int stride = JOURNAL_CHECKPOINT_INTERVAL;
+
+    while((unsigned long)count > ((unsigned long)JOURNAL_CHECKPOINTS * stride))
+    {
+        stride <<= 1;
+    }
+    return stride;
+}
+
+// Writes the state into the slot that is not current, the checkpoints of
+// the current slot are carried over (only the even ones after a rebase)
+static void journal_write(JOURNAL_Data *journal, unsigned char checkpoint, unsigned long address, unsigned char rebase)
+{
+    unsigned char data[JOURNAL_SLOT_SIZE];
+
+    if(journal->generation)
+    {
+        at24cm0x_read_sequential(journal_slot(journal, journal->slot), data, JOURNAL_SLOT_SIZE);
+    }
+    else
+    {
+        memset(data, 0x00, JOURNAL_SLOT_SIZE);
+    }
+
+    if(rebase)
+    {
+        for (unsigned char i=1; i < (JOURNAL_CHECKPOINTS / 2); i++)
+        {
+            memcpy(&data[JOURNAL_CHECKPOINT_OFFSET + (3 * i)], &data[JOURNAL_CHECKPOINT_OFFSET + (6 * i)], 3);
+        }
+    }
+
+    journal->generation++;
+    journal->slot ^= 1;
+
+    journal_set(&data[4], journal->generation, 4);
+    journal_set(&data[8], journal->head, 3);
+    journal_set(&data[11], journal->tail, 3);
+    journal_set(&data[14], journal->count, 2);
+
+    if(checkpoint < JOURNAL_CHECKPOINTS)
+    {
+        journal_set(&data[JOURNAL_CHECKPOINT_OFFSET + (3 * checkpoint)], address, 3);
+    }
+    journal_seal(data, 'J', JOURNAL_SLOT_SIZE);
+
+    at24cm0x_write_page(journal_slot(journal, journal->slot), data, JOURNAL_SLOT_SIZE);
+}
+
+JOURNAL_Status journal_format(JOURNAL_Data *journal, unsigned long address, unsigned long start, unsigned long end, const unsigned char *device)
+{
+    unsigned char data[JOURNAL_SUPERBLOCK_SIZE];
+
+    journal->address = address;
+    journal->start = start;
+    journal->end = end;
+    memcpy(journal->device, device, JOURNAL_DEVICE_SIZE);
+
+    // Both slots are invalidated first, an interrupted format mounts as invalid
+    memset(data, 0x00, JOURNAL_SUPERBLOCK_SIZE);
+    at24cm0x_write_page(journal_slot(journal, 0), data, 4);
+    at24cm0x_write_page(journal_slot(journal, 1), data, 4);
+
+    journal_set(&data[4], start, 3);
+    journal_set(&data[7], end, 3);
+    memcpy(&data[10], device, JOURNAL_DEVICE_SIZE);
+    journal_seal(data, 'S', JOURNAL_SUPERBLOCK_SIZE);
+
+    at24cm0x_write_page(address, data, JOURNAL_SUPERBLOCK_SIZE);
+
+    journal->slot = 1;
+    journal->generation = 0UL;
+    journal->head = start;
+    journal->tail = start;
+    journal->count = 0;
+
+    journal_write(journal, JOURNAL_CHECKPOINTS, 0UL, 0);
+
+    return JOURNAL_Status_Valid;
+}
+
+JOURNAL_Status journal_mount(JOURNAL_Data *journal, unsigned long address, const unsigned char *device)
+{
+    unsigned char data[JOURNAL_SLOT_SIZE];
+    unsigned char mounted = 0;
+
+    journal->address = address;
+
+    at24cm0x_read_sequential(address, data, JOURNAL_SUPERBLOCK_SIZE);
+
+    if(!journal_valid(data, 'S', JOURNAL_SUPERBLOCK_SIZE))
+    {
+        return JOURNAL_Status_Invalid;
+    }
+
+    journal->start = journal_get(&data[4], 3);
+    journal->end = journal_get(&data[7], 3);
+    memcpy(journal->device, &data[10], JOURNAL_DEVICE_SIZE);
+
+    // Newest valid slot wins (generation compared with wrap around)
+    for (unsigned char slot=0; slot < 2; slot++)
+    {
+        unsigned long generation;
+
+        at24cm0x_read_sequential(journal_slot(journal, slot), data, JOURNAL_SLOT_SIZE);
+
+        if(!journal_valid(data, 'J', JOURNAL_SLOT_SIZE))
+        {
+            continue;
+        }
+
+        generation = journal_get(&data[4], 4);
+
+        if(!mounted || ((long)(generation - journal->generation) > 0L))
+        {
+            journal->slot = slot;
+            journal->generation = generation;
+            journal->head = journal_get(&data[8], 3);
+            journal->tail = journal_get(&data[11], 3);
+            journal->count = (unsigned int)journal_get(&data[14], 2);
+            mounted = 1;
+        }
+    }
+
+    if(!mounted)
+    {
+        return JOURNAL_Status_Invalid;
+    }
+
+    if(memcmp(journal->device, device, JOURNAL_DEVICE_SIZE))
+    {
+        return JOURNAL_Status_Foreign;
+    }
+    return JOURNAL_Status_Valid;
+}
+
+void journal_commit(JOURNAL_Data *journal)
+{
+    journal_write(journal, JOURNAL_CHECKPOINTS, 0UL, 0);
+}
+
+// The record has to be written at head before it is committed
+void journal_append(JOURNAL_Data *journal, unsigned int size)
+{
+    unsigned char checkpoint = JOURNAL_CHECKPOINTS;
+    unsigned long address = journal->head;
+    unsigned int stride = journal_stride(journal->count + 1);
+
+    if(!(journal->count % stride))
+    {
+        checkpoint = (unsigned char)(journal->count / stride);
+    }
+
+    journal->head += size;
+    journal->count++;
+
+    journal_write(journal, checkpoint, address, (stride != journal_stride(journal->count - 1)));
+}
+
+// Nearest checkpoint at or before index, returns its record number
+unsigned int journal_checkpoint(const JOURNAL_Data *journal, unsigned int index, unsigned long *address)
+{
+    unsigned char data[3];
+    unsigned int stride = journal_stride(journal->count);
+    unsigned int checkpoint = index / stride;
+
+    if(checkpoint >= JOURNAL_CHECKPOINTS)
+    {
+        checkpoint = JOURNAL_CHECKPOINTS - 1;
+    }
+
+    at24cm0x_read_sequential(journal_slot(journal, journal->slot) + JOURNAL_CHECKPOINT_OFFSET + (3 * checkpoint), data, 3);
+    *address = journal_get(data, 3);
+
+    return checkpoint * stride;
+}
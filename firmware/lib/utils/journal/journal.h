@@ -0,0 +1,75 @@
+
+#ifndef JOURNAL_H_
+#define JOURNAL_H_
+
+    // Vault metadata in three reserved AT24CM02 pages:
+    // Superblock: 'V' | 'S' | VERSION | RFU | START (3) | END (3) | DEVICE[9] | CRC16
+    // Slot A/B:   'V' | 'J' | VERSION | RFU | GENERATION (4) | HEAD (3) | TAIL (3) |
+    //             COUNT (2) | CHECKPOINT[JOURNAL_CHECKPOINTS] (3 each) | CRC16
+    // A commit writes the slot that is not current with GENERATION + 1. A
+    // write torn by power loss fails the CRC and the other slot stays
+    // valid, so mounting is three small reads instead of a vault scan.
+    // CHECKPOINT[n] is the address of record n * STRIDE, checkpoints stay in
+    // the EEPROM and are carried over on every commit. STRIDE starts at
+    // JOURNAL_CHECKPOINT_INTERVAL and doubles (the even checkpoints are kept)
+    // once COUNT exceeds JOURNAL_CHECKPOINTS * STRIDE, it follows from COUNT.
+    // A lookup walks less than STRIDE record headers, at most
+    // max(JOURNAL_CHECKPOINT_INTERVAL, 2 * COUNT / JOURNAL_CHECKPOINTS).
+    // All multi byte values LSB first, CRC16 is CRC-XMODEM.
+
+    #ifndef JOURNAL_CHECKPOINTS
+        #define JOURNAL_CHECKPOINTS 16
+    #endif
+
+    #if (JOURNAL_CHECKPOINTS % 2)
+        #error "JOURNAL_CHECKPOINTS has to be even"
+    #endif
+
+    #ifndef JOURNAL_CHECKPOINT_INTERVAL
+        #define JOURNAL_CHECKPOINT_INTERVAL 16
+    #endif
+
+    #ifndef JOURNAL_PAGE_SIZE
+        #define JOURNAL_PAGE_SIZE 256UL
+    #endif
+
+    #define JOURNAL_VERSION 1
+    #define JOURNAL_DEVICE_SIZE 9
+    #define JOURNAL_SUPERBLOCK_SIZE (4 + 3 + 3 + JOURNAL_DEVICE_SIZE + 2)
+    #define JOURNAL_SLOT_SIZE (4 + 4 + 3 + 3 + 2 + (3 * JOURNAL_CHECKPOINTS) + 2)
+    #define JOURNAL_SIZE (3 * JOURNAL_PAGE_SIZE)
+
+    #include <string.h>
+    #include <util/crc16.h>
+
+    #include "../../drivers/prom/at24cm0x/at24cm0x.h"
+
+    enum JOURNAL_Status_t
+    {
+        JOURNAL_Status_Valid=0,
+        JOURNAL_Status_Invalid,
+        JOURNAL_Status_Foreign
+    };
+    typedef enum JOURNAL_Status_t JOURNAL_Status;
+
+    typedef struct
+    {
+        unsigned long address;
+        unsigned long start;
+        unsigned long end;
+        unsigned char device[JOURNAL_DEVICE_SIZE];
+        unsigned char slot;
+        unsigned long generation;
+        unsigned long head;
+        unsigned long tail;
+        unsigned int count;
+    } JOURNAL_Data;
+
+    JOURNAL_Status journal_format(JOURNAL_Data *journal, unsigned long address, unsigned long start, unsigned long end, const unsigned char *device);
+    JOURNAL_Status journal_mount(JOURNAL_Data *journal, unsigned long address, const unsigned char *device);
+    void journal_commit(JOURNAL_Data *journal);
+
+    void journal_append(JOURNAL_Data *journal, unsigned int size);
+    unsigned int journal_checkpoint(const JOURNAL_Data *journal, unsigned int index, unsigned long *address);
+
+#endif /* JOURNAL_H_ */
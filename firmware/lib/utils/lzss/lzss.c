@@ -0,0 +1,153 @@
+
+#include "lzss.h"
+
+static void lzss_flush(const unsigned char *group, unsigned char size, void (*output)(unsigned char data))
+{
+    if(output)
+    {
+        for (unsigned char i=0; i < size; i++)
+        {
+            output(group[i]);
+        }
+    }
+}
+
+// Dictionary and record form one stream, matches may start in the dictionary
+static unsigned char lzss_byte(const LZSS_Dictionary *dictionary, const unsigned char *data, unsigned int position)
+{
+    if(position < dictionary->length)
+    {
+        return dictionary->data[position];
+    }
+    return data[position - dictionary->length];
+}
+
+// Returns the packed size, output == 0 only measures the record
+unsigned int lzss_encode(const LZSS_Dictionary *dictionary, const unsigned char *data, unsigned int length, void (*output)(unsigned char data))
+{
+    unsigned char group[1 + (2 * 8)];
+    unsigned char size = 1;
+    unsigned char tokens = 0;
+    unsigned int packed = 0;
+    unsigned int position = dictionary->length;
+    unsigned int end = dictionary->length + length;
+
+    group[0] = 0;
+
+    while(position < end)
+    {
+        unsigned int start = (position > LZSS_WINDOW_SIZE) ? (position - LZSS_WINDOW_SIZE) : 0;
+        unsigned int limit = end - position;
+        unsigned int match_length = 0;
+        unsigned int match_offset = 0;
+
+        if(limit > LZSS_MATCH_MAX)
+        {
+            limit = LZSS_MATCH_MAX;
+        }
+
+        // Brute force search, records are short and the window is small
+        for (unsigned int candidate = start; (candidate < position) && (match_length < limit); candidate++)
+        {
+            unsigned int match = 0;
+
+            while((match < limit) && (lzss_byte(dictionary, data, candidate + match) == lzss_byte(dictionary, data, position + match)))
+            {
+                match++;
+            }
+
+            if(match > match_length)
+            {
+                match_length = match;
+                match_offset = position - candidate;
+            }
+        }
+
+        if(match_length >= LZSS_MATCH_MIN)
+        {
+            group[size++] = (unsigned char)(match_offset - 1);
+            group[size++] = (unsigned char)(match_length - LZSS_MATCH_MIN);
+            position += match_length;
+        }
+        else
+        {
+            group[0] |= (1 << tokens);
+            group[size++] = lzss_byte(dictionary, data, position++);
+        }
+
+        if(++tokens == 8)
+        {
+            lzss_flush(group, size, output);
+            packed += size;
+
+            group[0] = 0;
+            size = 1;
+            tokens = 0;
+        }
+    }
+
+    if(tokens)
+    {
+        lzss_flush(group, size, output);
+        packed += size;
+    }
+    return packed;
+}
+
+void lzss_decode_init(LZSS_Decoder *decoder, const LZSS_Dictionary *dictionary, void (*output)(unsigned char data))
+{
+    decoder->output = output;
+    decoder->state = LZSS_State_Flags;
+    decoder->position = (unsigned char)dictionary->length;
+
+    memcpy(decoder->window, dictionary->data, dictionary->length);
+}
+
+static void lzss_emit(LZSS_Decoder *decoder, unsigned char data)
+{
+    decoder->window[decoder->position++ & (LZSS_WINDOW_SIZE - 1)] = data;
+    decoder->output(data);
+}
+
+// Feeds one packed byte, decoded bytes are passed to the output function
+void lzss_decode(LZSS_Decoder *decoder, unsigned char data)
+{
+    switch(decoder->state)
+    {
+        case LZSS_State_Flags:
+            decoder->flags = data;
+            decoder->tokens = 8;
+            decoder->state = LZSS_State_Token;
+        return;
+
+        case LZSS_State_Token:
+            if(!(decoder->flags & 0x01))
+            {
+                decoder->offset = data;
+                decoder->state = LZSS_State_Length;
+                return;
+            }
+            lzss_emit(decoder, data);
+        break;
+
+        case LZSS_State_Length:
+        {
+            unsigned char source = decoder->position - decoder->offset - 1;
+            unsigned int length = data + LZSS_MATCH_MIN;
+
+            while(length--)
+            {
+                lzss_emit(decoder, decoder->window[source++ & (LZSS_WINDOW_SIZE - 1)]);
+            }
+            decoder->state = LZSS_State_Token;
+        }
+        break;
+    }
+
+    decoder->flags >>= 1;
+
+    if(!(--decoder->tokens))
+    {
+        decoder->state = LZSS_State_Flags;
+    }
+}
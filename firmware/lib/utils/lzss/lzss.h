@@ -0,0 +1,58 @@
+
+#ifndef LZSS_H_
+#define LZSS_H_
+
+    // LZSS stream:
+    // FLAGS | TOKEN[8] | FLAGS | TOKEN[8] | ...
+    // FLAGS bit n (LSB first) describes token n: 1 -> literal byte,
+    // 0 -> match of two bytes: OFFSET-1 | LENGTH-LZSS_MATCH_MIN.
+    // The decoder only keeps the last LZSS_WINDOW_SIZE output bytes, so a
+    // record is decompressed while it is read without a record buffer.
+    // A preset dictionary (common fragments) primes the window, short
+    // records have little redundancy of their own.
+
+    #ifndef LZSS_WINDOW_SIZE
+        #define LZSS_WINDOW_SIZE 128
+    #endif
+
+    #define LZSS_MATCH_MIN 3
+    #define LZSS_MATCH_MAX (LZSS_MATCH_MIN + 255)
+
+    #if (LZSS_WINDOW_SIZE > 256) || (LZSS_WINDOW_SIZE & (LZSS_WINDOW_SIZE - 1))
+        #error "LZSS_WINDOW_SIZE has to be a power of 2 <= 256"
+    #endif
+
+    #include <string.h>
+
+    enum LZSS_State_t
+    {
+        LZSS_State_Flags=0,
+        LZSS_State_Token,
+        LZSS_State_Length
+    };
+    typedef enum LZSS_State_t LZSS_State;
+
+    // length <= LZSS_WINDOW_SIZE
+    typedef struct
+    {
+        const unsigned char *data;
+        unsigned char length;
+    } LZSS_Dictionary;
+
+    typedef struct
+    {
+        void (*output)(unsigned char data);
+        LZSS_State state;
+        unsigned char flags;
+        unsigned char tokens;
+        unsigned char offset;
+        unsigned char position;
+        unsigned char window[LZSS_WINDOW_SIZE];
+    } LZSS_Decoder;
+
+    unsigned int lzss_encode(const LZSS_Dictionary *dictionary, const unsigned char *data, unsigned int length, void (*output)(unsigned char data));
+
+    void lzss_decode_init(LZSS_Decoder *decoder, const LZSS_Dictionary *dictionary, void (*output)(unsigned char data));
+    void lzss_decode(LZSS_Decoder *decoder, unsigned char data);
+
+#endif /* LZSS_H_ */
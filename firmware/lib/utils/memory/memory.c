@@ -0,0 +1,57 @@
+
+#include "memory.h"
+
+extern unsigned char _end;
+extern unsigned char __stack;
+
+#define MEMORY_STRING(value) MEMORY_VALUE(value)
+#define MEMORY_VALUE(value) #value
+
+void memory_paint(void) __attribute__((naked, used, section(".init3")));
+
+// Runs between stack pointer setup (.init2) and main, nothing is on the
+// stack yet and the function is entered by fall through (no return).
+// Assembly only: a naked function has no frame for C locals to spill to.
+void memory_paint(void)
+{
+    __asm__ __volatile__(
+        "ldi r30, lo8(_end)\n\t"
+        "ldi r31, hi8(_end)\n\t"
+        "ldi r26, lo8(__stack)\n\t"
+        "ldi r27, hi8(__stack)\n\t"
+        "ldi r24, " MEMORY_STRING(MEMORY_PAINT) "\n\t"
+        "1: st Z+, r24\n\t"
+        "cp r26, r30\n\t"
+        "cpc r27, r31\n\t"
+        "brsh 1b\n\t"
+    );
+}
+
+// .data, .bss and .noinit
+unsigned int memory_static(void)
+{
+    return (unsigned int)(&_end - (unsigned char *)RAMSTART);
+}
+
+// Gap between static data and the current stack pointer
+unsigned int memory_free(void)
+{
+    return (unsigned int)((unsigned char *)SP - &_end);
+}
+
+// Bytes above static data the stack has never reached since reset
+unsigned int memory_unused(void)
+{
+    const unsigned char *data = &_end;
+
+    while((data <= &__stack) && (*data == MEMORY_PAINT))
+    {
+        data++;
+    }
+    return (unsigned int)(data - &_end);
+}
+
+unsigned int memory_stack_peak(void)
+{
+    return (unsigned int)(&__stack - &_end) + 1U - memory_unused();
+}
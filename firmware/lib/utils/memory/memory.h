@@ -0,0 +1,21 @@
+
+#ifndef MEMORY_H_
+#define MEMORY_H_
+
+    // SRAM layout (ATtiny1604, 1kB):
+    // RAMSTART | .data | .bss | .noinit | _end ... free ... <- SP | RAMEND
+    // The free area is painted before main (.init3), bytes the stack ever
+    // used lose the pattern, so the high-water mark survives until reset.
+
+    #ifndef MEMORY_PAINT
+        #define MEMORY_PAINT 0xC5
+    #endif
+
+    #include <avr/io.h>
+
+    unsigned int memory_static(void);
+    unsigned int memory_free(void);
+    unsigned int memory_unused(void);
+    unsigned int memory_stack_peak(void);
+
+#endif /* MEMORY_H_ */
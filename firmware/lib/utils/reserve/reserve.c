@@ -0,0 +1,277 @@
+
+#include "reserve.h"
+
+static const unsigned char reserve_erased[RESERVE_ERASE_SIZE] = { [0 ... (RESERVE_ERASE_SIZE - 1)] = 0xFF };
+
+static unsigned long reserve_page(const RESERVE_Data *reserve, unsigned char page)
+{
+    return reserve->address + ((unsigned long)page * RESERVE_PAGE_SIZE);
+}
+
+static unsigned char reserve_valid(const RESERVE_Data *reserve, unsigned char page)
+{
+    return reserve->valid[page >> 3] & (1 << (page & 7));
+}
+
+// Pages already in the requested state are left alone, level stays consistent
+static void reserve_mark(RESERVE_Data *reserve, unsigned char page, unsigned char valid)
+{
+    if(!reserve_valid(reserve, page) == !valid)
+    {
+        return;
+    }
+
+    if(valid)
+    {
+        reserve->valid[page >> 3] |= (1 << (page & 7));
+        reserve->level++;
+        return;
+    }
+    reserve->valid[page >> 3] &= ~(1 << (page & 7));
+    reserve->level--;
+}
+
+// Next page from index on (cyclic) that is valid or not
+static unsigned char reserve_next(const RESERVE_Data *reserve, unsigned char index, unsigned char valid)
+{
+    for (unsigned char i=0; i < reserve->pages; i++)
+    {
+        unsigned char page = (unsigned char)((index + i) % reserve->pages);
+
+        if(!reserve_valid(reserve, page) == !valid)
+        {
+            return page;
+        }
+    }
+    return 0;
+}
+
+static unsigned int reserve_check(const RESERVE_Data *reserve, const unsigned char *trailer, unsigned char page)
+{
+    const unsigned char *key = (const unsigned char *)reserve->key;
+    unsigned int crc = 0;
+
+    for (unsigned char i=0; i < (RESERVE_TRAILER_SIZE - 2); i++)
+    {
+        crc = _crc_xmodem_update(crc, trailer[i]);
+    }
+    crc = _crc_xmodem_update(crc, page);
+
+    for (unsigned char i=0; i < XTEA_KEY_SIZE; i++)
+    {
+        crc = _crc_xmodem_update(crc, key[i]);
+    }
+    return crc;
+}
+
+// Returns 1 and the epoch of a valid page, 2 for a page in service
+static unsigned char reserve_trailer(const RESERVE_Data *reserve, unsigned char page, unsigned long *epoch)
+{
+    unsigned char trailer[RESERVE_TRAILER_SIZE];
+
+    at24cm0x_read_sequential(reserve_page(reserve, page) + RESERVE_DATA_SIZE, trailer, RESERVE_TRAILER_SIZE);
+
+    *epoch = (unsigned long)trailer[2] | ((unsigned long)trailer[3] << 8) | ((unsigned long)trailer[4] << 16) | ((unsigned long)trailer[5] << 24);
+
+    if((trailer[0] == 'R') && (trailer[1] == RESERVE_SERVED))
+    {
+        return 2;
+    }
+    return	(trailer[0] == 'R') && (trailer[1] == 'S') &&
+            (reserve_check(reserve, trailer, page) == (unsigned int)(trailer[6] | (trailer[7] << 8)));
+}
+
+// XOR with the keystream, offset is the position in the page data
+static void reserve_crypt(const RESERVE_Data *reserve, unsigned char page, unsigned long epoch, unsigned char offset, unsigned char *data, unsigned char length)
+{
+    unsigned long block[XTEA_BLOCK_SIZE / 4];
+
+    while(length)
+    {
+        block[0] = epoch;
+        block[1] = ((unsigned long)page << 8) | (offset / XTEA_BLOCK_SIZE);
+        xtea_encrypt(reserve->key, block);
+
+        for (unsigned char i = (offset % XTEA_BLOCK_SIZE); (i < XTEA_BLOCK_SIZE) && length; i++, length--, offset++)
+        {
+            *(data++) ^= ((const unsigned char *)block)[i];
+        }
+    }
+}
+
+// Trailer first, an interrupted erase leaves no valid page behind.
+// The driver only reads the data, reserve_erased stays in flash.
+static void reserve_erase(RESERVE_Data *reserve, unsigned char page)
+{
+    for (unsigned int offset = RESERVE_PAGE_SIZE; offset; offset -= RESERVE_ERASE_SIZE)
+    {
+        at24cm0x_write_page(reserve_page(reserve, page) + offset - RESERVE_ERASE_SIZE, (unsigned char *)reserve_erased, RESERVE_ERASE_SIZE);
+    }
+    reserve_mark(reserve, page, 0);
+}
+
+void reserve_init(RESERVE_Data *reserve, unsigned long address, unsigned char pages, const unsigned long *key, unsigned long epoch)
+{
+    memset(reserve, 0, sizeof(RESERVE_Data));
+    memcpy(reserve->key, key, XTEA_KEY_SIZE);
+
+    reserve->address = address;
+    reserve->pages = (pages > RESERVE_PAGES_MAX) ? RESERVE_PAGES_MAX : pages;
+    reserve->epoch = epoch;
+}
+
+// One trailer per call, the caller keeps running meanwhile
+RESERVE_Status reserve_scan(RESERVE_Data *reserve)
+{
+    unsigned long epoch;
+
+    if(reserve->scan > reserve->pages)
+    {
+        return RESERVE_Status_Ready;
+    }
+
+    if(reserve->scan < reserve->pages)
+    {
+        switch(reserve_trailer(reserve, reserve->scan, &epoch))
+        {
+            case 1: reserve_mark(reserve, reserve->scan, 1); break;
+            // Served partly before the power loss, its data may have left the board
+            case 2: reserve_erase(reserve, reserve->scan); break;
+        }
+        reserve->scan++;
+
+        return RESERVE_Status_Busy;
+    }
+
+    // Serving starts at the beginning of the filled run, filling at its end
+    for (unsigned char page=0; page < reserve->pages; page++)
+    {
+        unsigned char previous = (page ? page : reserve->pages) - 1;
+
+        if(reserve_valid(reserve, page) && !reserve_valid(reserve, previous))
+        {
+            reserve->serve = page;
+        }
+
+        if(!reserve_valid(reserve, page) && reserve_valid(reserve, previous))
+        {
+            reserve->fill = page;
+        }
+    }
+
+    reserve->scan++;
+
+    return RESERVE_Status_Ready;
+}
+
+// Encrypts data in place and writes it to the page being filled.
+// Wrapped -> nothing written, the caller persists the new epoch and repeats the call.
+RESERVE_Status reserve_fill(RESERVE_Data *reserve, unsigned char *data, unsigned char length)
+{
+    unsigned char trailer[RESERVE_TRAILER_SIZE];
+    unsigned int crc;
+
+    if((reserve->scan <= reserve->pages) || (reserve->level >= reserve->pages))
+    {
+        return RESERVE_Status_Full;
+    }
+
+    if(!reserve->position)
+    {
+        unsigned char page = reserve_next(reserve, reserve->fill, 0);
+
+        if(page < reserve->fill)
+        {
+            reserve->fill = page;
+            reserve->epoch++;
+
+            return RESERVE_Status_Wrapped;
+        }
+        reserve->fill = page;
+    }
+
+    if(length > (RESERVE_DATA_SIZE - reserve->position))
+    {
+        length = RESERVE_DATA_SIZE - reserve->position;
+    }
+
+    reserve_crypt(reserve, reserve->fill, reserve->epoch, reserve->position, data, length);
+    at24cm0x_write_page(reserve_page(reserve, reserve->fill) + reserve->position, data, length);
+    reserve->position += length;
+
+    if(reserve->position < RESERVE_DATA_SIZE)
+    {
+        return RESERVE_Status_Busy;
+    }
+
+    trailer[0] = 'R';
+    trailer[1] = 'S';
+    trailer[2] = (unsigned char)reserve->epoch;
+    trailer[3] = (unsigned char)(reserve->epoch >> 8);
+    trailer[4] = (unsigned char)(reserve->epoch >> 16);
+    trailer[5] = (unsigned char)(reserve->epoch >> 24);
+
+    crc = reserve_check(reserve, trailer, reserve->fill);
+    trailer[6] = (unsigned char)crc;
+    trailer[7] = (unsigned char)(crc >> 8);
+
+    at24cm0x_write_page(reserve_page(reserve, reserve->fill) + RESERVE_DATA_SIZE, trailer, RESERVE_TRAILER_SIZE);
+    reserve_mark(reserve, reserve->fill, 1);
+
+    reserve->fill++;
+    reserve->position = 0;
+
+    return RESERVE_Status_Page;
+}
+
+// Drops the partly filled page, e.g. after a failed health test.
+// Its counter blocks are already used, the page is filled again under a
+// new epoch: the caller persists it before the next reserve_fill.
+void reserve_abandon(RESERVE_Data *reserve)
+{
+    if(reserve->position)
+    {
+        reserve->position = 0;
+        reserve->epoch++;
+    }
+}
+
+unsigned long reserve_available(const RESERVE_Data *reserve)
+{
+    return ((unsigned long)reserve->level * RESERVE_DATA_SIZE) - reserve->offset;
+}
+
+// Returns the bytes read, at most up to the end of the current page
+unsigned char reserve_read(RESERVE_Data *reserve, unsigned char *data, unsigned char length)
+{
+    if(!reserve->level)
+    {
+        return 0;
+    }
+
+    // The page is marked in service before its first byte leaves the board
+    if(!reserve->offset)
+    {
+        unsigned char served = RESERVE_SERVED;
+
+        reserve->serve = reserve_next(reserve, reserve->serve, 1);
+        reserve_trailer(reserve, reserve->serve, &reserve->serve_epoch);
+        at24cm0x_write_page(reserve_page(reserve, reserve->serve) + RESERVE_DATA_SIZE + 1, &served, 1);
+    }
+
+    if(length > (RESERVE_DATA_SIZE - reserve->offset))
+    {
+        length = RESERVE_DATA_SIZE - reserve->offset;
+    }
+
+    at24cm0x_read_sequential(reserve_page(reserve, reserve->serve) + reserve->offset, data, length);
+    reserve_crypt(reserve, reserve->serve, reserve->serve_epoch, reserve->offset, data, length);
+    reserve->offset += length;
+
+    if(reserve->offset >= RESERVE_DATA_SIZE)
+    {
+        reserve_erase(reserve, reserve->serve);
+        reserve->offset = 0;
+    }
+    return length;
+}
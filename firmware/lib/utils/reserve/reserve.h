@@ -0,0 +1,74 @@
+
+#ifndef RESERVE_H_
+#define RESERVE_H_
+
+    // Encrypted entropy reserve in AT24CM02 pages, filled while the board
+    // is idle and served in bursts at EEPROM read speed:
+    // PAGE: DATA[RESERVE_DATA_SIZE] | 'R' | 'S' | EPOCH (4 bytes) | CHECK (2 bytes)
+    // DATA is XTEA-CTR encrypted, counter block: EPOCH | PAGE << 8 | DATA offset / 8.
+    // The trailer is written after the data, a fill torn by power loss
+    // leaves an invalid page. CHECK is the CRC16 of trailer, page index and
+    // key, pages of another key do not mount.
+    // A new EPOCH is used after every mount, every wrap of the fill index
+    // and every abandoned page, so a counter block is never encrypted twice
+    // under one key.
+    // Pages are served in fill order and erased when they are used up.
+    // Before the first byte of a page is served its trailer is marked
+    // 'R' | RESERVE_SERVED, a page in service at power loss is erased at the
+    // next mount, its data may already have left the board.
+
+    #ifndef RESERVE_PAGE_SIZE
+        #define RESERVE_PAGE_SIZE 256U
+    #endif
+
+    #define RESERVE_TRAILER_SIZE 8U
+    #define RESERVE_SERVED 'U'
+    #define RESERVE_DATA_SIZE (RESERVE_PAGE_SIZE - RESERVE_TRAILER_SIZE)
+    #define RESERVE_PAGES_MAX 128U
+    // Erased data is written from flash, a full page costs one write cycle
+    #ifndef RESERVE_ERASE_SIZE
+        #define RESERVE_ERASE_SIZE RESERVE_PAGE_SIZE
+    #endif
+
+    #include <string.h>
+    #include <util/crc16.h>
+
+    #include "../../drivers/prom/at24cm0x/at24cm0x.h"
+    #include "../xtea/xtea.h"
+
+    enum RESERVE_Status_t
+    {
+        RESERVE_Status_Ready=0,
+        RESERVE_Status_Busy,
+        RESERVE_Status_Page,
+        RESERVE_Status_Wrapped,
+        RESERVE_Status_Full
+    };
+    typedef enum RESERVE_Status_t RESERVE_Status;
+
+    typedef struct
+    {
+        unsigned long address;
+        unsigned char pages;
+        unsigned long key[XTEA_KEY_SIZE / 4];
+        unsigned long epoch;
+        unsigned char scan;
+        unsigned char valid[RESERVE_PAGES_MAX / 8];
+        unsigned char fill;
+        unsigned char position;
+        unsigned char serve;
+        unsigned char offset;
+        unsigned long serve_epoch;
+        unsigned char level;
+    } RESERVE_Data;
+
+    void reserve_init(RESERVE_Data *reserve, unsigned long address, unsigned char pages, const unsigned long *key, unsigned long epoch);
+    RESERVE_Status reserve_scan(RESERVE_Data *reserve);
+
+    RESERVE_Status reserve_fill(RESERVE_Data *reserve, unsigned char *data, unsigned char length);
+    void reserve_abandon(RESERVE_Data *reserve);
+
+    unsigned long reserve_available(const RESERVE_Data *reserve);
+    unsigned char reserve_read(RESERVE_Data *reserve, unsigned char *data, unsigned char length);
+
+#endif /* RESERVE_H_ */
@@ -0,0 +1,78 @@
+
+#include "scheduler.h"
+
+static volatile unsigned long scheduler_tick_count = 0UL;
+static unsigned long scheduler_start = 0UL;
+
+// Called from the RTC overflow interrupt (~ every millisecond)
+void scheduler_tick(void)
+{
+    scheduler_tick_count++;
+}
+
+unsigned long scheduler_ticks(void)
+{
+    unsigned long ticks;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        ticks = scheduler_tick_count;
+    }
+    return ticks;
+}
+
+unsigned char scheduler_expired(unsigned long tick)
+{
+    return ((long)(scheduler_ticks() - tick) >= 0L);
+}
+
+// Timestamp in RTC counts: sub-millisecond resolution for run accounting
+unsigned long scheduler_timestamp(void)
+{
+    unsigned long ticks;
+    unsigned int count;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        ticks = scheduler_tick_count;
+        count = RTC.CNT;
+
+        // Overflow pending but not yet serviced by the RTC interrupt
+        if(RTC.INTFLAGS & RTC_OVF_bm)
+        {
+            ticks++;
+            count = RTC.CNT;
+        }
+    }
+    return (ticks * ((unsigned long)RTC.PER + 1UL)) + count;
+}
+
+void scheduler_run(SCHEDULER_Task *tasks, unsigned char count)
+{
+    for (unsigned char i=0; i < count; i++)
+    {
+        unsigned long start = scheduler_timestamp();
+
+        // Polls of a waiting task are not accounted, they show up as idle
+        if(tasks[i].handler(&tasks[i]) == SCHEDULER_Status_Yield)
+        {
+            tasks[i].busy += scheduler_timestamp() - start;
+            tasks[i].runs++;
+        }
+    }
+}
+
+void scheduler_reset(SCHEDULER_Task *tasks, unsigned char count)
+{
+    for (unsigned char i=0; i < count; i++)
+    {
+        tasks[i].runs = 0UL;
+        tasks[i].busy = 0UL;
+    }
+    scheduler_start = scheduler_timestamp();
+}
+
+unsigned long scheduler_elapsed(void)
+{
+    return scheduler_timestamp() - scheduler_start;
+}
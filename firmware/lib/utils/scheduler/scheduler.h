@@ -0,0 +1,77 @@
+
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+    #include <avr/io.h>
+    #include <util/atomic.h>
+
+    // Cooperative tasks are written as protothreads: the resume point is
+    // stored in task->state, so local variables do NOT survive a yield.
+    // Keep state that spans a yield in static variables.
+    // A call that only re-checks an unfulfilled wait condition returns
+    // SCHEDULER_Status_Waiting and is not accounted as a run, a call that
+    // resumes after a yield is.
+
+    #define SCHEDULER_BEGIN(task)                                       \
+        SCHEDULER_Status scheduler_status = SCHEDULER_Status_Waiting;   \
+        switch((task)->state) { case 0: scheduler_status = SCHEDULER_Status_Yield;
+
+    #define SCHEDULER_YIELD(task)                       \
+        do {                                            \
+            (task)->state = __LINE__;                   \
+            return SCHEDULER_Status_Yield;              \
+            case __LINE__:                              \
+            scheduler_status = SCHEDULER_Status_Yield;  \
+        } while(0)
+
+    #define SCHEDULER_WAIT_UNTIL(task, condition)       \
+        do {                                            \
+            (task)->state = __LINE__;                   \
+            case __LINE__:                              \
+            if(!(condition))                            \
+            {                                           \
+                return scheduler_status;                \
+            }                                           \
+            scheduler_status = SCHEDULER_Status_Yield;  \
+        } while(0)
+
+    #define SCHEDULER_SLEEP(task, ms)                                           \
+        do {                                                                    \
+            (task)->wakeup = scheduler_ticks() + (ms);                          \
+            SCHEDULER_WAIT_UNTIL(task, scheduler_expired((task)->wakeup));     \
+        } while(0)
+
+    #define SCHEDULER_END(task) } (task)->state = 0; return SCHEDULER_Status_Yield
+
+    #define SCHEDULER_TASK(name, handler) { (name), (handler), 0U, 0UL, 0UL, 0UL }
+
+    enum SCHEDULER_Status_t
+    {
+        SCHEDULER_Status_Waiting=0,
+        SCHEDULER_Status_Yield
+    };
+    typedef enum SCHEDULER_Status_t SCHEDULER_Status;
+
+    typedef struct SCHEDULER_Task_t SCHEDULER_Task;
+    typedef SCHEDULER_Status (*SCHEDULER_Handler)(SCHEDULER_Task *task);
+
+    struct SCHEDULER_Task_t
+    {
+        const char *name;
+        SCHEDULER_Handler handler;
+        unsigned int state;
+        unsigned long wakeup;
+        unsigned long runs;
+        unsigned long busy;
+    };
+
+    void scheduler_tick(void);
+    unsigned long scheduler_ticks(void);
+    unsigned char scheduler_expired(unsigned long tick);
+    unsigned long scheduler_timestamp(void);
+
+    void scheduler_run(SCHEDULER_Task *tasks, unsigned char count);
+    void scheduler_reset(SCHEDULER_Task *tasks, unsigned char count);
+    unsigned long scheduler_elapsed(void);
+
+#endif /* SCHEDULER_H_ */
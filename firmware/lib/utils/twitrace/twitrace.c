@@ -0,0 +1,189 @@
+
+#include "twitrace.h"
+
+#ifdef TWI_TRACE_EN
+
+static TWITRACE_Record twitrace_ring[TWITRACE_SIZE];
+static TWITRACE_Record *twitrace_last = 0;
+static unsigned char twitrace_head = 0;
+static unsigned char twitrace_count = 0;
+static unsigned char twitrace_lost = 0;
+static unsigned char twitrace_enabled = 1;
+static unsigned int twitrace_time = 0;
+static unsigned char twitrace_time_valid = 0;
+static unsigned int twitrace_epoch = 0;
+
+TWI_Error __real_twi_start(void);
+TWI_Error __real_twi_address(unsigned char address, TWI_Operation operation);
+TWI_Error __real_twi_set(unsigned char data);
+TWI_Error __real_twi_get(unsigned char *data, TWI_Acknowledge acknowledge);
+void __real_twi_stop(void);
+
+static TWITRACE_Record *twitrace_push(unsigned char event, unsigned char value, unsigned int timestamp)
+{
+    TWITRACE_Record *record = &twitrace_ring[twitrace_head];
+
+    // Keep the upper 16 bits of the oldest record when its TIME record is overwritten
+    if((twitrace_count == TWITRACE_SIZE) && (record->event == TWITRACE_Event_Time))
+    {
+        twitrace_epoch = record->timestamp;
+    }
+
+    record->event = event;
+    record->value = value;
+    record->timestamp = timestamp;
+
+    twitrace_head = (twitrace_head + 1) % TWITRACE_SIZE;
+
+    if(twitrace_count < TWITRACE_SIZE)
+    {
+        twitrace_count++;
+    }
+    else if(twitrace_lost < 0xFF)
+    {
+        twitrace_lost++;
+    }
+    twitrace_last = record;
+
+    return record;
+}
+
+static TWITRACE_Record *twitrace_record(unsigned char event, unsigned char value)
+{
+    unsigned long timestamp;
+
+    if(!twitrace_enabled)
+    {
+        return 0;
+    }
+
+    timestamp = scheduler_timestamp();
+
+    if(!twitrace_time_valid || ((unsigned int)(timestamp >> 16) != twitrace_time))
+    {
+        twitrace_time = (unsigned int)(timestamp >> 16);
+        twitrace_time_valid = 1;
+        twitrace_push(TWITRACE_Event_Time, 0, twitrace_time);
+    }
+
+    // Consecutive data bytes are counted in one record
+    if(	(event == (twitrace_last ? twitrace_last->event : 0)) &&
+        ((event & TWITRACE_EVENT_MASK) == TWITRACE_Event_Data) &&
+        (twitrace_last->value < 0xFF))
+    {
+        twitrace_last->value++;
+        twitrace_last->timestamp = (unsigned int)timestamp;
+        return twitrace_last;
+    }
+    return twitrace_push(event, value, (unsigned int)timestamp);
+}
+
+TWI_Error __wrap_twi_start(void)
+{
+    TWITRACE_Record *record = twitrace_record(TWITRACE_Event_Start, 0);
+    TWI_Error status = __real_twi_start();
+
+    if(record && status)
+    {
+        record->event |= TWITRACE_FLAG_ERROR;
+    }
+    return status;
+}
+
+TWI_Error __wrap_twi_address(unsigned char address, TWI_Operation operation)
+{
+    TWI_Error status = __real_twi_address(address, operation);
+
+    twitrace_record(TWITRACE_Event_Address | ((operation == TWI_Read) ? TWITRACE_FLAG_READ : 0) | (status ? TWITRACE_FLAG_ERROR : 0), address);
+    return status;
+}
+
+TWI_Error __wrap_twi_set(unsigned char data)
+{
+    TWI_Error status = __real_twi_set(data);
+
+    twitrace_record(TWITRACE_Event_Data | (status ? TWITRACE_FLAG_ERROR : 0), 1);
+    return status;
+}
+
+TWI_Error __wrap_twi_get(unsigned char *data, TWI_Acknowledge acknowledge)
+{
+    TWI_Error status = __real_twi_get(data, acknowledge);
+
+    twitrace_record(TWITRACE_Event_Data | TWITRACE_FLAG_READ | (status ? TWITRACE_FLAG_ERROR : 0), 1);
+    return status;
+}
+
+void __wrap_twi_stop(void)
+{
+    __real_twi_stop();
+    twitrace_record(TWITRACE_Event_Stop, 0);
+}
+
+void twitrace_enable(unsigned char enable)
+{
+    twitrace_enabled = enable;
+}
+
+void twitrace_clear(void)
+{
+    twitrace_head = 0;
+    twitrace_count = 0;
+    twitrace_lost = 0;
+    twitrace_last = 0;
+    twitrace_time_valid = 0;
+}
+
+// A wrapped ring starts with a TIME record for the oldest record
+static unsigned char twitrace_records(void)
+{
+    return twitrace_count + (twitrace_lost ? 1 : 0);
+}
+
+unsigned int twitrace_size(void)
+{
+    return TWITRACE_HEADER_SIZE + (twitrace_records() * TWITRACE_RECORD_SIZE);
+}
+
+// Serializes header and records (oldest first) from byte offset
+void twitrace_read(unsigned int offset, unsigned char *data, unsigned char length)
+{
+    unsigned char first = (twitrace_head + TWITRACE_SIZE - twitrace_count) % TWITRACE_SIZE;
+    unsigned int counts = RTC.PER + 1;
+    TWITRACE_Record epoch = { TWITRACE_Event_Time, 0, twitrace_epoch };
+
+    for (unsigned char i=0; i < length; i++, offset++)
+    {
+        if(offset < TWITRACE_HEADER_SIZE)
+        {
+            unsigned char header[TWITRACE_HEADER_SIZE] = { 'T', 'R', (unsigned char)counts, (unsigned char)(counts >> 8), twitrace_records(), twitrace_lost };
+
+            data[i] = header[offset];
+        }
+        else
+        {
+            unsigned int position = offset - TWITRACE_HEADER_SIZE;
+            unsigned char index = position / TWITRACE_RECORD_SIZE;
+            TWITRACE_Record *record = &epoch;
+
+            if(twitrace_lost)
+            {
+                index--;
+            }
+            if(index < TWITRACE_SIZE)
+            {
+                record = &twitrace_ring[(first + index) % TWITRACE_SIZE];
+            }
+
+            switch(position % TWITRACE_RECORD_SIZE)
+            {
+                case 0: data[i] = record->event; break;
+                case 1: data[i] = record->value; break;
+                case 2: data[i] = (unsigned char)record->timestamp; break;
+                default: data[i] = (unsigned char)(record->timestamp >> 8); break;
+            }
+        }
+    }
+}
+
+#endif
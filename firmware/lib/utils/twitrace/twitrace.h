@@ -0,0 +1,56 @@
+
+#ifndef TWITRACE_H_
+#define TWITRACE_H_
+
+    // TWI bus tracer, only built with TWI_TRACE_EN.
+    //
+    // The twi_* calls of all drivers are intercepted with the linker:
+    // -Wl,--wrap=twi_start,--wrap=twi_address,--wrap=twi_set,--wrap=twi_get,--wrap=twi_stop
+    // Without TWI_TRACE_EN (and the linker flags) nothing is compiled in.
+    //
+    // Records are kept in a SRAM ring (oldest are overwritten). A record
+    // holds the lower 16 bits of scheduler_timestamp() (RTC counts), a
+    // TIME record carries the upper 16 bits whenever they change. Once the
+    // ring has wrapped (LOST > 0) the dump starts with an extra TIME record
+    // for the oldest record, its own TIME record may have been overwritten.
+    //
+    // Dump: 'T' | 'R' | RTC counts per ms (2 bytes) | RECORDS | LOST | RECORD[RECORDS]
+    // Record: EVENT | VALUE | TIMESTAMP (2 bytes, LSB first)
+
+    #ifndef TWITRACE_SIZE
+        #define TWITRACE_SIZE 24
+    #endif
+
+    #define TWITRACE_HEADER_SIZE 6
+    #define TWITRACE_RECORD_SIZE 4
+
+    #define TWITRACE_FLAG_ERROR 0x80
+    #define TWITRACE_FLAG_READ 0x40
+    #define TWITRACE_EVENT_MASK 0x0F
+
+    #include "../../hal/avr0/twi/twi.h"
+    #include "../scheduler/scheduler.h"
+
+    enum TWITRACE_Event_t
+    {
+        TWITRACE_Event_Start=1,
+        TWITRACE_Event_Address,
+        TWITRACE_Event_Data,
+        TWITRACE_Event_Stop,
+        TWITRACE_Event_Time
+    };
+    typedef enum TWITRACE_Event_t TWITRACE_Event;
+
+    typedef struct
+    {
+        unsigned char event;
+        unsigned char value;
+        unsigned int timestamp;
+    } TWITRACE_Record;
+
+    void twitrace_enable(unsigned char enable);
+    void twitrace_clear(void);
+    unsigned int twitrace_size(void);
+    void twitrace_read(unsigned int offset, unsigned char *data, unsigned char length);
+
+#endif /* TWITRACE_H_ */
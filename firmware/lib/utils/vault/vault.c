@@ -0,0 +1,165 @@
+
+#include "vault.h"
+
+static unsigned char vault_chunk[VAULT_CHUNK_SIZE];
+static unsigned char vault_chunk_size;
+static unsigned long vault_address;
+
+#ifdef VAULT_LZSS_EN
+    static LZSS_Decoder *vault_decoder = 0;
+
+    // Changing the dictionary makes existing compressed records unreadable
+    static const unsigned char vault_dictionary_data[] = "https://www..com/login user: password: pass: email: @gmail.com the and ";
+    static const LZSS_Dictionary vault_dictionary = { vault_dictionary_data, sizeof(vault_dictionary_data) - 1 };
+#endif
+
+static void vault_flush(void)
+{
+    if(vault_chunk_size)
+    {
+        at24cm0x_write_page(vault_address, vault_chunk, vault_chunk_size);
+        vault_address += vault_chunk_size;
+        vault_chunk_size = 0;
+    }
+}
+
+// Collects bytes until the chunk is full or the EEPROM page ends
+static void vault_put(unsigned char data)
+{
+    vault_chunk[vault_chunk_size++] = data;
+
+    if((vault_chunk_size == VAULT_CHUNK_SIZE) || !((vault_address + vault_chunk_size) % VAULT_PAGE_SIZE))
+    {
+        vault_flush();
+    }
+}
+
+// The decoder is only used during vault_read, its memory may be shared
+void vault_init(LZSS_Decoder *decoder)
+{
+#ifdef VAULT_LZSS_EN
+    vault_decoder = decoder;
+#endif
+}
+
+VAULT_Status vault_write(unsigned long address, const unsigned char *data, unsigned int length, unsigned int *packed)
+{
+    unsigned int size = length;
+
+    if(!length || (length == VAULT_EMPTY))
+    {
+        return VAULT_Status_Invalid;
+    }
+
+#ifdef VAULT_LZSS_EN
+    // Dry run first: incompressible records are stored as is
+    size = lzss_encode(&vault_dictionary, data, length, 0);
+
+    if(size > length)
+    {
+        size = length;
+    }
+#endif
+
+    vault_address = address;
+    vault_chunk_size = 0;
+
+    vault_put((unsigned char)length);
+    vault_put((unsigned char)(length >> 8));
+    vault_put((unsigned char)size);
+    vault_put((unsigned char)(size >> 8));
+
+#ifdef VAULT_LZSS_EN
+    if(size < length)
+    {
+        lzss_encode(&vault_dictionary, data, length, vault_put);
+    }
+    else
+#endif
+    {
+        for (unsigned int i=0; i < length; i++)
+        {
+            vault_put(data[i]);
+        }
+    }
+    vault_flush();
+
+    *packed = size;
+    return VAULT_Status_Valid;
+}
+
+VAULT_Status vault_info(unsigned long address, unsigned int *length, unsigned int *packed)
+{
+    unsigned char header[VAULT_HEADER_SIZE];
+
+    at24cm0x_read_sequential(address, header, VAULT_HEADER_SIZE);
+
+    *length = header[0] | (header[1] << 8);
+    *packed = header[2] | (header[3] << 8);
+
+    if(*length == VAULT_EMPTY)
+    {
+        return VAULT_Status_Empty;
+    }
+
+    if(!(*length) || (*packed > *length))
+    {
+        return VAULT_Status_Invalid;
+    }
+    return VAULT_Status_Valid;
+}
+
+VAULT_Status vault_read(unsigned long address, void (*output)(unsigned char data), unsigned int *length)
+{
+    VAULT_Status status;
+    unsigned char compressed;
+    unsigned int packed;
+
+    status = vault_info(address, length, &packed);
+
+    if(status != VAULT_Status_Valid)
+    {
+        return status;
+    }
+
+    compressed = (packed < *length);
+
+#ifdef VAULT_LZSS_EN
+    if(compressed && !vault_decoder)
+    {
+        return VAULT_Status_Invalid;
+    }
+    lzss_decode_init(vault_decoder, &vault_dictionary, output);
+#else
+    if(compressed)
+    {
+        return VAULT_Status_Invalid;
+    }
+#endif
+
+    address += VAULT_HEADER_SIZE;
+
+    while(packed)
+    {
+        unsigned char size = (packed > VAULT_CHUNK_SIZE) ? VAULT_CHUNK_SIZE : (unsigned char)packed;
+
+        at24cm0x_read_sequential(address, vault_chunk, size);
+
+        for (unsigned char i=0; i < size; i++)
+        {
+#ifdef VAULT_LZSS_EN
+            if(compressed)
+            {
+                lzss_decode(vault_decoder, vault_chunk[i]);
+            }
+            else
+#endif
+            {
+                output(vault_chunk[i]);
+            }
+        }
+        address += size;
+        packed -= size;
+    }
+    return VAULT_Status_Valid;
+}
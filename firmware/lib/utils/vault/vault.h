@@ -0,0 +1,39 @@
+
+#ifndef VAULT_H_
+#define VAULT_H_
+
+    // Vault record in the AT24CM02:
+    // LENGTH (2 bytes, LSB first) | PACKED (2 bytes, LSB first) | DATA[PACKED]
+    // PACKED < LENGTH:  DATA is LZSS compressed (VAULT_LZSS_EN)
+    // PACKED == LENGTH: DATA is stored as is (incompressible, e.g. hex keys)
+    // Records are written and read in chunks, compressed data is decoded
+    // while it is read with the decoder passed to vault_init.
+
+    #ifndef VAULT_PAGE_SIZE
+        #define VAULT_PAGE_SIZE 256UL
+    #endif
+
+    #ifndef VAULT_CHUNK_SIZE
+        #define VAULT_CHUNK_SIZE 32
+    #endif
+
+    #define VAULT_HEADER_SIZE 4
+    #define VAULT_EMPTY 0xFFFFU
+
+    #include "../../drivers/prom/at24cm0x/at24cm0x.h"
+    #include "../lzss/lzss.h"
+
+    enum VAULT_Status_t
+    {
+        VAULT_Status_Valid=0,
+        VAULT_Status_Empty,
+        VAULT_Status_Invalid
+    };
+    typedef enum VAULT_Status_t VAULT_Status;
+
+    void vault_init(LZSS_Decoder *decoder);
+    VAULT_Status vault_write(unsigned long address, const unsigned char *data, unsigned int length, unsigned int *packed);
+    VAULT_Status vault_info(unsigned long address, unsigned int *length, unsigned int *packed);
+    VAULT_Status vault_read(unsigned long address, void (*output)(unsigned char data), unsigned int *length);
+
+#endif /* VAULT_H_ */
@@ -0,0 +1,89 @@
+
+#include "wordlist.h"
+
+WORDLIST_Status wordlist_mount(unsigned long address, WORDLIST_Info *info)
+{
+    unsigned char header[WORDLIST_HEADER_SIZE];
+
+    at24cm0x_read_sequential(address, header, sizeof(header));
+
+    if(header[0] != 'V' || header[1] != 'W' || header[4] < 2)
+    {
+        return WORDLIST_Status_Invalid;
+    }
+
+    info->address = address + WORDLIST_HEADER_SIZE;
+    info->count = header[2] | (header[3] << 8);
+    info->width = header[4];
+
+    if(info->count == 0)
+    {
+        return WORDLIST_Status_Invalid;
+    }
+    return WORDLIST_Status_Valid;
+}
+
+// Unbiased rejection sampling: 16 bit random values above the largest
+// multiple of count are rejected (returns 0), the caller draws again
+unsigned char wordlist_select(const WORDLIST_Info *info, unsigned int random, unsigned int *index)
+{
+    unsigned long limit = 0x10000UL - (0x10000UL % info->count);
+
+    if(random >= limit)
+    {
+        return 0;
+    }
+    *index = random % info->count;
+
+    return 1;
+}
+
+// Reads the words of indices in as few TWI transactions as possible:
+// slots are read in ascending index order, neighbouring indices are
+// merged into one sequential read and duplicates are copied.
+// words receives the slots in ascending order, slots[i] is the slot of
+// indices[i], so the caller keeps the original (random) word order.
+void wordlist_read(const WORDLIST_Info *info, const unsigned int *indices, unsigned char count, char *words, unsigned char *slots)
+{
+    unsigned char order[WORDLIST_WORDS_MAX];
+
+    for (unsigned char i=0; i < count; i++)
+    {
+        unsigned char j = i;
+
+        while(j && (indices[order[j - 1]] > indices[i]))
+        {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+
+    for (unsigned char i=0; i < count; i++)
+    {
+        slots[order[i]] = i;
+    }
+
+    unsigned char start = 0;
+
+    while(start < count)
+    {
+        unsigned char end = start + 1;
+
+        if(start && (indices[order[start]] == indices[order[start - 1]]))
+        {
+            memcpy(&words[start * info->width], &words[(start - 1) * info->width], info->width);
+            start++;
+            continue;
+        }
+
+        while((end < count) && (indices[order[end]] == (indices[order[end - 1]] + 1)))
+        {
+            end++;
+        }
+
+        at24cm0x_read_sequential(info->address + ((unsigned long)indices[order[start]] * info->width), (unsigned char *)&words[start * info->width], (end - start) * info->width);
+
+        start = end;
+    }
+}
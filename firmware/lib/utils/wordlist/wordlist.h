@@ -0,0 +1,39 @@
+
+#ifndef WORDLIST_H_
+#define WORDLIST_H_
+
+    // Wordlist image in the AT24CM02:
+    // 'V' | 'W' | COUNT (2 bytes, LSB first) | WIDTH | RFU[3] | SLOT[COUNT]
+    // Every word occupies a fixed, NUL padded slot of WIDTH bytes, so the
+    // slot address is computed from the word index and a word costs one
+    // random read.
+
+    #ifndef WORDLIST_WORDS_MAX
+        #define WORDLIST_WORDS_MAX 16
+    #endif
+
+    #define WORDLIST_HEADER_SIZE 8
+
+    #include <string.h>
+
+    #include "../../drivers/prom/at24cm0x/at24cm0x.h"
+
+    enum WORDLIST_Status_t
+    {
+        WORDLIST_Status_Valid=0,
+        WORDLIST_Status_Invalid
+    };
+    typedef enum WORDLIST_Status_t WORDLIST_Status;
+
+    typedef struct
+    {
+        unsigned long address;
+        unsigned int count;
+        unsigned char width;
+    } WORDLIST_Info;
+
+    WORDLIST_Status wordlist_mount(unsigned long address, WORDLIST_Info *info);
+    unsigned char wordlist_select(const WORDLIST_Info *info, unsigned int random, unsigned int *index);
+    void wordlist_read(const WORDLIST_Info *info, const unsigned int *indices, unsigned char count, char *words, unsigned char *slots);
+
+#endif /* WORDLIST_H_ */
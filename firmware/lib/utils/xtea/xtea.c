@@ -0,0 +1,21 @@
+
+#include "xtea.h"
+
+#define XTEA_DELTA 0x9E3779B9UL
+
+void xtea_encrypt(const unsigned long *key, unsigned long *block)
+{
+    unsigned long v0 = block[0];
+    unsigned long v1 = block[1];
+    unsigned long sum = 0UL;
+
+    for (unsigned char i=0; i < XTEA_CYCLES; i++)
+    {
+        v0 += (((v1 << 4) ^ (v1 >> 5)) + v1) ^ (sum + key[sum & 3]);
+        sum += XTEA_DELTA;
+        v1 += (((v0 << 4) ^ (v0 >> 5)) + v0) ^ (sum + key[(sum >> 11) & 3]);
+    }
+
+    block[0] = v0;
+    block[1] = v1;
+}
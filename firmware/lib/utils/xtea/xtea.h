@@ -0,0 +1,17 @@
+
+#ifndef XTEA_H_
+#define XTEA_H_
+
+    // XTEA block cipher (Needham/Wheeler), 64 bit block, 128 bit key.
+    // Only the encryption direction is needed for CTR mode.
+
+    #ifndef XTEA_CYCLES
+        #define XTEA_CYCLES 32
+    #endif
+
+    #define XTEA_BLOCK_SIZE 8
+    #define XTEA_KEY_SIZE 16
+
+    void xtea_encrypt(const unsigned long *key, unsigned long *block);
+
+#endif /* XTEA_H_ */
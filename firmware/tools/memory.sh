@@ -0,0 +1,58 @@
+#!/bin/sh
+#
+# Static memory breakdown of a firmware image (post build step)
+#
+# memory.sh <firmware.elf> [symbols]
+#
+# Fails (exit 1) if less than STACK bytes (default 128, SRAM_STACK_RESERVE
+# in main.h) stay free for the stack or the image exceeds FLASH bytes,
+# which fails the build. The application is linked behind the BOOT section
+# (default 16384 - 1024 bytes), the bootloader has to fit the BOOT section:
+# FLASH=1024 (BOOT_SIZE in VLT_BOOT_1_0/main.h).
+#
+# Atmel Studio: Project -> Properties -> Build Events -> Post-build:
+# sh "$(MSBuildProjectDirectory)/../tools/memory.sh" "$(OutputDirectory)/$(OutputFileName).elf"
+
+ELF="$1"
+SYMBOLS="${2:-15}"
+SRAM=1024
+FLASH="${FLASH:-15360}"
+STACK="${STACK:-128}"
+
+if [ ! -f "$ELF" ]; then
+    echo "usage: memory.sh <firmware.elf> [symbols]" >&2
+    exit 2
+fi
+
+avr-size -A "$ELF" | awk -v sram=$SRAM -v flash=$FLASH -v stack=$STACK '
+    $1 == ".text" || $1 == ".rodata" { text += $2 }
+    $1 == ".data"                    { data = $2 }
+    $1 == ".bss"                     { bss = $2 }
+    $1 == ".noinit"                  { noinit = $2 }
+    $1 ~ /^\.(text|rodata|data|bss|noinit)$/ { printf("%-10s %6u bytes\n", $1, $2) }
+    END {
+        ram = data + bss + noinit
+        printf("\nFlash      %6u / %u bytes (%.1f%%)\n", text + data, flash, 100.0 * (text + data) / flash)
+        printf("SRAM       %6u / %u bytes (%.1f%%), %d bytes left for the stack\n", ram, sram, 100.0 * ram / sram, sram - ram)
+
+        if((sram - ram) < stack)
+        {
+            printf("error: less than %u bytes left for the stack\n", stack)
+            exit 1
+        }
+
+        if((text + data) > flash)
+        {
+            printf("error: image exceeds %u bytes of flash\n", flash)
+            exit 1
+        }
+    }'
+
+STATUS=$?
+
+echo
+echo "Largest SRAM objects:"
+avr-nm -t d --size-sort --reverse-sort -S "$ELF" | awk -v n="$SYMBOLS" '
+    $3 ~ /^[bBdD]$/ && count < n { printf("%6u  %s\n", $2, $4); count++ }'
+
+exit $STATUS
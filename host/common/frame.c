@@ -0,0 +1,96 @@
+
+#include "frame.h"
+#include "serial.h"
+
+#include <string.h>
+
+// CRC-XMODEM, identical to avr-libc _crc_xmodem_update()
+unsigned int frame_crc(unsigned int crc, const unsigned char *data, unsigned int length)
+{
+    while(length--)
+    {
+        crc ^= (unsigned int)(*(data++)) << 8;
+
+        for (unsigned char i=0; i < 8; i++)
+        {
+            crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+        }
+        crc &= 0xFFFF;
+    }
+    return crc;
+}
+
+int frame_write(int fd, unsigned char command, unsigned char sequence, const unsigned char *payload, unsigned char length)
+{
+    unsigned char data[4 + FRAME_PAYLOAD_SIZE + 2];
+    unsigned int crc;
+
+    data[0] = FRAME_START;
+    data[1] = command;
+    data[2] = sequence;
+    data[3] = length;
+    memcpy(&data[4], payload, length);
+
+    crc = frame_crc(0, &data[1], 3U + length);
+    data[4 + length] = (unsigned char)crc;
+    data[5 + length] = (unsigned char)(crc >> 8);
+
+    return serial_write(fd, data, 6U + length);
+}
+
+FRAME_Status frame_read(int fd, FRAME_Data *frame, int timeout)
+{
+    return frame_wait(fd, frame, timeout, timeout);
+}
+
+// Waits up to timeout (ms) for START, the rest of the frame may take up to
+// frame_timeout: USB adapters deliver a frame in parts (latency timer)
+FRAME_Status frame_wait(int fd, FRAME_Data *frame, int timeout, int frame_timeout)
+{
+    unsigned char data = 0;
+    unsigned char crc[2];
+    int status;
+
+    do
+    {
+        status = serial_read(fd, &data, 1, timeout);
+
+        if(status <= 0)
+        {
+            return (status < 0) ? FRAME_Status_Error : FRAME_Status_Timeout;
+        }
+    } while(data != FRAME_START);
+
+    if((status = serial_read(fd, &frame->command, 3, frame_timeout)) != 3)
+    {
+        return (status < 0) ? FRAME_Status_Error : FRAME_Status_Timeout;
+    }
+
+    if((status = serial_read(fd, frame->payload, frame->length, frame_timeout)) != frame->length)
+    {
+        return (status < 0) ? FRAME_Status_Error : FRAME_Status_Timeout;
+    }
+
+    if((status = serial_read(fd, crc, 2, frame_timeout)) != 2)
+    {
+        return (status < 0) ? FRAME_Status_Error : FRAME_Status_Timeout;
+    }
+
+    if(frame_crc(frame_crc(0, &frame->command, 3), frame->payload, frame->length) != (unsigned int)(crc[0] | (crc[1] << 8)))
+    {
+        return FRAME_Status_Corrupt;
+    }
+    return FRAME_Status_Ready;
+}
+
+unsigned long frame_get_address(const unsigned char *data)
+{
+    return (unsigned long)data[0] | ((unsigned long)data[1] << 8) | ((unsigned long)data[2] << 16);
+}
+
+void frame_set_address(unsigned char *data, unsigned long address)
+{
+    data[0] = (unsigned char)address;
+    data[1] = (unsigned char)(address >> 8);
+    data[2] = (unsigned char)(address >> 16);
+}
@@ -0,0 +1,59 @@
+
+#ifndef FRAME_H_
+#define FRAME_H_
+
+    // Host side of the firmware frame protocol (firmware/lib/utils/frame)
+    // START | COMMAND | SEQUENCE | LENGTH | PAYLOAD[LENGTH] | CRC16 (LSB first)
+
+    #define FRAME_START 0x02
+    #define FRAME_CHUNK_SIZE 64
+    #define FRAME_ADDRESS_SIZE 3
+    #define FRAME_PAYLOAD_SIZE 255
+
+    enum FRAME_Command_t
+    {
+        FRAME_Command_Ack=0x01,
+        FRAME_Command_Nak=0x02,
+        FRAME_Command_Dump=0x10,
+        FRAME_Command_Restore=0x11,
+        FRAME_Command_Data=0x12,
+        FRAME_Command_Read=0x13,
+        FRAME_Command_Write=0x14,
+        FRAME_Command_Random=0x15,
+        FRAME_Command_Status=0x16,
+        FRAME_Command_Reserve=0x17,
+        FRAME_Command_Trace=0x20,
+        FRAME_Command_Boot=0x30,
+        FRAME_Command_Program=0x31,
+        FRAME_Command_Verify=0x32,
+        FRAME_Command_Run=0x33
+    };
+    typedef enum FRAME_Command_t FRAME_Command;
+
+    enum FRAME_Status_t
+    {
+        FRAME_Status_Error=-1,
+        FRAME_Status_Timeout=0,
+        FRAME_Status_Ready=1,
+        FRAME_Status_Corrupt=2
+    };
+    typedef enum FRAME_Status_t FRAME_Status;
+
+    typedef struct
+    {
+        unsigned char command;
+        unsigned char sequence;
+        unsigned char length;
+        unsigned char payload[FRAME_PAYLOAD_SIZE];
+    } FRAME_Data;
+
+    unsigned int frame_crc(unsigned int crc, const unsigned char *data, unsigned int length);
+
+    int frame_write(int fd, unsigned char command, unsigned char sequence, const unsigned char *payload, unsigned char length);
+    FRAME_Status frame_read(int fd, FRAME_Data *frame, int timeout);
+    FRAME_Status frame_wait(int fd, FRAME_Data *frame, int timeout, int frame_timeout);
+
+    unsigned long frame_get_address(const unsigned char *data);
+    void frame_set_address(unsigned char *data, unsigned long address);
+
+#endif /* FRAME_H_ */
@@ -0,0 +1,141 @@
+
+#include "serial.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+static speed_t serial_speed(unsigned long baudrate)
+{
+    switch(baudrate)
+    {
+        case 9600:    return B9600;
+        case 19200:   return B19200;
+        case 38400:   return B38400;
+        case 57600:   return B57600;
+        case 115200:  return B115200;
+        case 230400:  return B230400;
+#ifdef B500000
+        case 500000:  return B500000;
+#endif
+#ifdef B1000000
+        case 1000000: return B1000000;
+#endif
+        default:      return 0;
+    }
+}
+
+int serial_open(const char *device, unsigned long baudrate)
+{
+    struct termios tty;
+    speed_t speed = serial_speed(baudrate);
+    int fd;
+
+    if(!speed)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    fd = open(device, O_RDWR | O_NOCTTY);
+
+    if(fd < 0)
+    {
+        return -1;
+    }
+
+    if(tcgetattr(fd, &tty) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    cfmakeraw(&tty);
+    cfsetispeed(&tty, speed);
+    cfsetospeed(&tty, speed);
+    tty.c_cflag |= CLOCAL | CREAD;
+    tty.c_cc[VMIN] = 0;
+    tty.c_cc[VTIME] = 0;
+
+    if(tcsetattr(fd, TCSANOW, &tty) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+    tcflush(fd, TCIOFLUSH);
+
+    return fd;
+}
+
+void serial_close(int fd)
+{
+    close(fd);
+}
+
+int serial_write(int fd, const unsigned char *data, size_t length)
+{
+    while(length)
+    {
+        ssize_t written = write(fd, data, length);
+
+        if(written < 0)
+        {
+            if(errno == EINTR || errno == EAGAIN)
+            {
+                continue;
+            }
+            return -1;
+        }
+        data += written;
+        length -= (size_t)written;
+    }
+    return 0;
+}
+
+// Returns the number of bytes read, less than length on timeout (ms),
+// -1 on errors and on hang-up (e.g. the adapter was unplugged)
+int serial_read(int fd, unsigned char *data, size_t length, int timeout)
+{
+    size_t received = 0;
+
+    while(received < length)
+    {
+        struct pollfd descriptor = { fd, POLLIN, 0 };
+        int status = poll(&descriptor, 1, timeout);
+
+        if(status < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+
+        if(status == 0)
+        {
+            break;
+        }
+
+        ssize_t count = read(fd, data + received, length - received);
+
+        if(count < 0)
+        {
+            if(errno == EINTR || errno == EAGAIN)
+            {
+                continue;
+            }
+            return -1;
+        }
+
+        // Readable without data: end of file
+        if(count == 0)
+        {
+            return -1;
+        }
+        received += (size_t)count;
+    }
+    return (int)received;
+}
@@ -0,0 +1,13 @@
+
+#ifndef SERIAL_H_
+#define SERIAL_H_
+
+    #include <stddef.h>
+
+    int serial_open(const char *device, unsigned long baudrate);
+    void serial_close(int fd);
+
+    int serial_write(int fd, const unsigned char *data, size_t length);
+    int serial_read(int fd, unsigned char *data, size_t length, int timeout);
+
+#endif /* SERIAL_H_ */
@@ -0,0 +1,516 @@
+
+#include "vlt.hpp"
+
+extern "C"
+{
+    #include "../common/frame.h"
+    #include "../common/serial.h"
+}
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+#include <utility>
+
+#define VLT_VAULT_SIZE 0x40000UL
+#define VLT_PAGE_SIZE 256U
+#define VLT_STATUS_SIZE 28U
+// Only while waiting for START, a started frame gets its wire time plus
+// the latency of USB adapters (FTDI latency timer 16 ms, more under load)
+#define VLT_POLL_INTERVAL 20
+#define VLT_LATENCY 100
+
+namespace vlt
+{
+    struct Client::Request
+    {
+        Callback done;
+        std::size_t parts;
+        Result result;
+    };
+
+    const char *result_string(Result result)
+    {
+        switch(result)
+        {
+            case Result::Ok:       return "ok";
+            case Result::Rejected: return "rejected by the device";
+            case Result::Timeout:  return "no response";
+            case Result::Closed:   return "connection closed";
+        }
+        return "unknown";
+    }
+
+    Error::Error(Result result) : std::runtime_error(result_string(result)), result_(result)
+    {
+    }
+
+    Client::Client(const std::string &device, const Options &options)
+        : options_(options), fd_(-1), frame_timeout_(VLT_LATENCY), sequence_(0), running_(true), pending_(0), statistics_()
+    {
+        if(!options_.window)
+        {
+            options_.window = 1;
+        }
+
+        if(options_.baudrate)
+        {
+            frame_timeout_ += static_cast<int>(((6UL + FRAME_PAYLOAD_SIZE) * 10000UL) / options_.baudrate);
+        }
+
+        fd_ = serial_open(device.c_str(), options_.baudrate);
+
+        if(fd_ < 0)
+        {
+            throw std::system_error(errno, std::generic_category(), device);
+        }
+        thread_ = std::thread(&Client::receive, this);
+    }
+
+    Client::~Client()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_ = false;
+        }
+        thread_.join();
+        serial_close(fd_);
+    }
+
+    void Client::read(std::uint32_t address, std::uint8_t *buffer, std::size_t length, Callback done)
+    {
+        submit(FRAME_Command_Read, address, buffer, length, FRAME_CHUNK_SIZE, std::move(done));
+    }
+
+    // Only read from, Part keeps one pointer type for both directions
+    void Client::write(std::uint32_t address, const std::uint8_t *data, std::size_t length, Callback done)
+    {
+        submit(FRAME_Command_Write, address, const_cast<std::uint8_t *>(data), length, FRAME_CHUNK_SIZE, std::move(done));
+    }
+
+    void Client::random(std::uint8_t *buffer, std::size_t length, Callback done)
+    {
+        submit(FRAME_Command_Random, 0, buffer, length, FRAME_CHUNK_SIZE, std::move(done));
+    }
+
+    void Client::reserve(std::uint8_t *buffer, std::size_t length, Callback done)
+    {
+        submit(FRAME_Command_Reserve, 0, buffer, length, FRAME_CHUNK_SIZE, std::move(done));
+    }
+
+    void Client::status(Status *status, Callback done)
+    {
+        submit(FRAME_Command_Status, 0, reinterpret_cast<std::uint8_t *>(status), VLT_STATUS_SIZE, VLT_STATUS_SIZE, std::move(done));
+    }
+
+    static Callback future_callback(std::shared_ptr<std::promise<void>> promise)
+    {
+        return [promise](Result result)
+        {
+            if(result == Result::Ok)
+            {
+                promise->set_value();
+            }
+            else
+            {
+                promise->set_exception(std::make_exception_ptr(Error(result)));
+            }
+        };
+    }
+
+    std::future<void> Client::read(std::uint32_t address, std::uint8_t *buffer, std::size_t length)
+    {
+        auto promise = std::make_shared<std::promise<void>>();
+        auto future = promise->get_future();
+
+        read(address, buffer, length, future_callback(promise));
+        return future;
+    }
+
+    std::future<void> Client::write(std::uint32_t address, const std::uint8_t *data, std::size_t length)
+    {
+        auto promise = std::make_shared<std::promise<void>>();
+        auto future = promise->get_future();
+
+        write(address, data, length, future_callback(promise));
+        return future;
+    }
+
+    std::future<void> Client::random(std::uint8_t *buffer, std::size_t length)
+    {
+        auto promise = std::make_shared<std::promise<void>>();
+        auto future = promise->get_future();
+
+        random(buffer, length, future_callback(promise));
+        return future;
+    }
+
+    std::future<void> Client::reserve(std::uint8_t *buffer, std::size_t length)
+    {
+        auto promise = std::make_shared<std::promise<void>>();
+        auto future = promise->get_future();
+
+        reserve(buffer, length, future_callback(promise));
+        return future;
+    }
+
+    std::future<Status> Client::status()
+    {
+        auto promise = std::make_shared<std::promise<Status>>();
+        auto status = std::make_shared<Status>();
+        auto future = promise->get_future();
+
+        this->status(status.get(), [promise, status](Result result)
+        {
+            if(result == Result::Ok)
+            {
+                promise->set_value(*status);
+            }
+            else
+            {
+                promise->set_exception(std::make_exception_ptr(Error(result)));
+            }
+        });
+        return future;
+    }
+
+    void Client::flush()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        idle_.wait(lock, [this] { return !pending_; });
+    }
+
+    Statistics Client::statistics() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        return statistics_;
+    }
+
+    // Splits a request into parts of at most limit bytes, writes also at page boundaries
+    void Client::submit(std::uint8_t command, std::uint32_t address, std::uint8_t *data, std::size_t length, std::size_t limit, Callback done)
+    {
+        if(	((command == FRAME_Command_Read) || (command == FRAME_Command_Write)) &&
+            ((address > VLT_VAULT_SIZE) || (length > (VLT_VAULT_SIZE - address))))
+        {
+            throw std::out_of_range("vlt: request exceeds the AT24CM02");
+        }
+
+        if(!length)
+        {
+            done(Result::Ok);
+            return;
+        }
+
+        auto request = std::make_shared<Request>();
+
+        request->done = std::move(done);
+        request->parts = 0;
+        request->result = Result::Ok;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        if(!running_)
+        {
+            throw Error(Result::Closed);
+        }
+
+        while(length)
+        {
+            std::size_t size = std::min(length, limit);
+
+            if(command == FRAME_Command_Write)
+            {
+                size = std::min<std::size_t>(size, VLT_PAGE_SIZE - (address % VLT_PAGE_SIZE));
+            }
+
+            queue_.push_back(Part{ request, command, address, data, size });
+            request->parts++;
+
+            address += ((command == FRAME_Command_Random) || (command == FRAME_Command_Reserve)) ? 0U : static_cast<std::uint32_t>(size);
+            data += size;
+            length -= size;
+        }
+        pending_++;
+
+        pump();
+    }
+
+    static bool vlt_batch(std::uint8_t command, std::uint32_t address, std::size_t length, const std::uint8_t next, std::uint32_t next_address, std::size_t next_length)
+    {
+        if((next != command) || (command == FRAME_Command_Status) || ((length + next_length) > FRAME_CHUNK_SIZE))
+        {
+            return false;
+        }
+
+        if((command == FRAME_Command_Random) || (command == FRAME_Command_Reserve))
+        {
+            return true;
+        }
+
+        if(next_address != (address + length))
+        {
+            return false;
+        }
+        return (command != FRAME_Command_Write) || (((address % VLT_PAGE_SIZE) + length + next_length) <= VLT_PAGE_SIZE);
+    }
+
+    // Fills the window with frames from the queue, called with the lock held
+    void Client::pump()
+    {
+        while((frames_.size() < options_.window) && !queue_.empty())
+        {
+            Frame frame;
+
+            frame.command = queue_.front().command;
+            frame.address = queue_.front().address;
+            frame.length = 0;
+            frame.retries = options_.retries;
+
+            do
+            {
+                const Part &part = queue_.front();
+
+                if(	!frame.parts.empty() &&
+                    (!options_.batching || !vlt_batch(frame.command, frame.address, frame.length, part.command, part.address, part.length)))
+                {
+                    break;
+                }
+
+                frame.length += part.length;
+                frame.parts.push_back(part);
+                queue_.pop_front();
+            } while(!queue_.empty());
+
+            transmit(frame);
+            frames_.push_back(std::move(frame));
+        }
+    }
+
+    int Client::transmit(Frame &frame)
+    {
+        unsigned char payload[FRAME_ADDRESS_SIZE + FRAME_CHUNK_SIZE];
+        unsigned char length = 0;
+
+        frame.sequence = sequence_++;
+        frame.deadline = std::chrono::steady_clock::now() + options_.timeout;
+
+        switch(frame.command)
+        {
+            case FRAME_Command_Read:
+                frame_set_address(payload, frame.address);
+                payload[FRAME_ADDRESS_SIZE] = static_cast<unsigned char>(frame.length);
+                length = FRAME_ADDRESS_SIZE + 1;
+            break;
+
+            case FRAME_Command_Write:
+                frame_set_address(payload, frame.address);
+                length = FRAME_ADDRESS_SIZE;
+
+                for (const Part &part : frame.parts)
+                {
+                    std::memcpy(&payload[length], part.data, part.length);
+                    length += static_cast<unsigned char>(part.length);
+                }
+            break;
+
+            case FRAME_Command_Random:
+            case FRAME_Command_Reserve:
+                payload[0] = static_cast<unsigned char>(frame.length);
+                length = 1;
+            break;
+
+            default:
+            break;
+        }
+        statistics_.frames++;
+
+        // A failed write is handled like a lost frame
+        return frame_write(fd_, frame.command, frame.sequence, payload, length);
+    }
+
+    static bool vlt_valid(std::uint8_t command, std::uint32_t address, std::size_t length, const FRAME_Data &reply)
+    {
+        switch(command)
+        {
+            case FRAME_Command_Read:
+                return	(reply.command == FRAME_Command_Data) && (reply.length == (FRAME_ADDRESS_SIZE + length)) &&
+                        (frame_get_address(reply.payload) == address);
+
+            case FRAME_Command_Random:
+            case FRAME_Command_Reserve:
+            case FRAME_Command_Status:
+                return (reply.command == FRAME_Command_Data) && (reply.length == (FRAME_ADDRESS_SIZE + length));
+
+            case FRAME_Command_Write:
+                return	(reply.command == FRAME_Command_Ack) && (reply.length == FRAME_ADDRESS_SIZE) &&
+                        (frame_get_address(reply.payload) == (address + length));
+        }
+        return false;
+    }
+
+    static void vlt_status(Status *status, const unsigned char *data)
+    {
+        status->uptime = static_cast<std::uint32_t>(data[0]) | (static_cast<std::uint32_t>(data[1]) << 8) |
+                         (static_cast<std::uint32_t>(data[2]) << 16) | (static_cast<std::uint32_t>(data[3]) << 24);
+        status->trng_pool = data[4];
+        status->rng90_pool = data[5];
+        status->journal = data[6];
+        status->records = static_cast<std::uint16_t>(data[7] | (data[8] << 8));
+        status->free = static_cast<std::uint32_t>(frame_get_address(&data[9]));
+        std::memcpy(status->device, &data[12], sizeof(status->device));
+        status->reserve = static_cast<std::uint32_t>(frame_get_address(&data[21]));
+        status->refill = static_cast<std::uint16_t>(data[24] | (data[25] << 8));
+        status->failures = static_cast<std::uint16_t>(data[26] | (data[27] << 8));
+    }
+
+    // Callbacks of finished requests are collected and called without the lock
+    void Client::finish(Frame &frame, Result result, Completion &completion)
+    {
+        for (Part &part : frame.parts)
+        {
+            Request &request = *part.request;
+
+            if(request.result == Result::Ok)
+            {
+                request.result = result;
+            }
+
+            if(!(--request.parts))
+            {
+                completion.emplace_back(std::move(request.done), request.result);
+                statistics_.requests++;
+                pending_--;
+            }
+        }
+    }
+
+    bool Client::retry(Frame &frame)
+    {
+        if(!frame.retries)
+        {
+            return false;
+        }
+
+        frame.retries--;
+        statistics_.retries++;
+        transmit(frame);
+
+        return true;
+    }
+
+    // Copies the reply data into the buffers of the batched parts
+    void Client::accept(Frame &frame, const std::uint8_t *data)
+    {
+        for (Part &part : frame.parts)
+        {
+            if(frame.command == FRAME_Command_Status)
+            {
+                vlt_status(reinterpret_cast<Status *>(part.data), data);
+            }
+            else if(frame.command != FRAME_Command_Write)
+            {
+                std::memcpy(part.data, data, part.length);
+            }
+            data += part.length;
+        }
+        statistics_.bytes += frame.length;
+    }
+
+    // Receive thread: matches replies by sequence number, retries lost or
+    // rejected frames and refills the window
+    void Client::receive()
+    {
+        while(1)
+        {
+            FRAME_Data reply;
+            FRAME_Status status = frame_wait(fd_, &reply, VLT_POLL_INTERVAL, frame_timeout_);
+            Completion completion;
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto now = std::chrono::steady_clock::now();
+
+                if(!running_ || (status == FRAME_Status_Error))
+                {
+                    running_ = false;
+
+                    for (Frame &frame : frames_)
+                    {
+                        finish(frame, Result::Closed, completion);
+                    }
+
+                    for (Part &part : queue_)
+                    {
+                        Frame frame{};
+
+                        frame.parts.push_back(std::move(part));
+                        finish(frame, Result::Closed, completion);
+                    }
+                    frames_.clear();
+                    queue_.clear();
+                }
+                else
+                {
+                    // Corrupt replies are left to the timeout, the sequence number is unreliable
+                    if(status == FRAME_Status_Ready)
+                    {
+                        auto frame = std::find_if(frames_.begin(), frames_.end(), [&reply](const Frame &candidate)
+                        {
+                            return candidate.sequence == reply.sequence;
+                        });
+
+                        if(frame != frames_.end())
+                        {
+                            if(vlt_valid(frame->command, frame->address, frame->length, reply))
+                            {
+                                accept(*frame, &reply.payload[FRAME_ADDRESS_SIZE]);
+                                finish(*frame, Result::Ok, completion);
+                                frames_.erase(frame);
+                            }
+                            else if(!retry(*frame))
+                            {
+                                finish(*frame, Result::Rejected, completion);
+                                frames_.erase(frame);
+                            }
+                        }
+                    }
+
+                    for (auto frame = frames_.begin(); frame != frames_.end();)
+                    {
+                        if((now < frame->deadline) || retry(*frame))
+                        {
+                            ++frame;
+                            continue;
+                        }
+
+                        finish(*frame, Result::Timeout, completion);
+                        frame = frames_.erase(frame);
+                    }
+                    pump();
+                }
+            }
+
+            for (auto &callback : completion)
+            {
+                callback.first(callback.second);
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+
+                if(!pending_)
+                {
+                    idle_.notify_all();
+                }
+
+                if(!running_)
+                {
+                    return;
+                }
+            }
+        }
+    }
+}
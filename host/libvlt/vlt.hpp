@@ -0,0 +1,169 @@
+
+#ifndef VLT_HPP_
+#define VLT_HPP_
+
+// Asynchronous host client for the VLT_FW_1_0 frame protocol.
+//
+// Every request is split into parts of at most FRAME_CHUNK_SIZE bytes
+// (writes also at AT24CM02 page boundaries). Queued parts of the same kind
+// are batched into one frame: random and reserve requests always, reads
+// and writes if their addresses are contiguous. Reserve requests are served
+// from the encrypted entropy reserve of the board, from its live sources
+// when the reserve runs dry. Up to `window` frames are in flight, the
+// firmware receives the next frame while the previous one is processed
+// (two receive buffers, so a window > 2 only provokes drops and retries).
+//
+// Data is read into and written from the caller's buffers, which have to
+// stay valid until the request completed. Callbacks run on the receive
+// thread and must not block. Requests are sent in order, but a retried
+// frame may overtake later ones: overlapping writes need a completed
+// request in between.
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace vlt
+{
+    enum class Result
+    {
+        Ok=0,
+        Rejected,
+        Timeout,
+        Closed
+    };
+
+    const char *result_string(Result result);
+
+    class Error : public std::runtime_error
+    {
+    public:
+        explicit Error(Result result);
+
+        Result result() const { return result_; }
+
+    private:
+        Result result_;
+    };
+
+    // Status payload of the firmware (frame_status)
+    struct Status
+    {
+        std::uint32_t uptime;
+        std::uint8_t trng_pool;
+        std::uint8_t rng90_pool;
+        std::uint8_t journal;
+        std::uint16_t records;
+        std::uint32_t free;
+        std::uint8_t device[9];
+        std::uint32_t reserve;
+        std::uint16_t refill;
+        std::uint16_t failures;
+    };
+
+    struct Options
+    {
+        unsigned long baudrate = 115200UL;
+        unsigned int window = 2;
+        bool batching = true;
+        std::chrono::milliseconds timeout{1000};
+        unsigned int retries = 5;
+    };
+
+    struct Statistics
+    {
+        std::uint64_t frames;
+        std::uint64_t retries;
+        std::uint64_t requests;
+        std::uint64_t bytes;
+    };
+
+    using Callback = std::function<void(Result result)>;
+
+    class Client
+    {
+    public:
+        explicit Client(const std::string &device, const Options &options = Options());
+        ~Client();
+
+        Client(const Client &) = delete;
+        Client &operator=(const Client &) = delete;
+
+        void read(std::uint32_t address, std::uint8_t *buffer, std::size_t length, Callback done);
+        void write(std::uint32_t address, const std::uint8_t *data, std::size_t length, Callback done);
+        void random(std::uint8_t *buffer, std::size_t length, Callback done);
+        void reserve(std::uint8_t *buffer, std::size_t length, Callback done);
+        void status(Status *status, Callback done);
+
+        // Futures throw vlt::Error from get() if the request failed
+        std::future<void> read(std::uint32_t address, std::uint8_t *buffer, std::size_t length);
+        std::future<void> write(std::uint32_t address, const std::uint8_t *data, std::size_t length);
+        std::future<void> random(std::uint8_t *buffer, std::size_t length);
+        std::future<void> reserve(std::uint8_t *buffer, std::size_t length);
+        std::future<Status> status();
+
+        // Blocks until every submitted request completed
+        void flush();
+
+        Statistics statistics() const;
+
+    private:
+        struct Request;
+
+        struct Part
+        {
+            std::shared_ptr<Request> request;
+            std::uint8_t command;
+            std::uint32_t address;
+            std::uint8_t *data;
+            std::size_t length;
+        };
+
+        struct Frame
+        {
+            std::uint8_t command;
+            std::uint8_t sequence;
+            std::uint32_t address;
+            std::size_t length;
+            std::vector<Part> parts;
+            std::chrono::steady_clock::time_point deadline;
+            unsigned int retries;
+        };
+
+        using Completion = std::vector<std::pair<Callback, Result>>;
+
+        void submit(std::uint8_t command, std::uint32_t address, std::uint8_t *data, std::size_t length, std::size_t limit, Callback done);
+        void pump();
+        int transmit(Frame &frame);
+        bool retry(Frame &frame);
+        void accept(Frame &frame, const std::uint8_t *data);
+        void finish(Frame &frame, Result result, Completion &completion);
+        void receive();
+
+        Options options_;
+        int fd_;
+        int frame_timeout_;
+        std::uint8_t sequence_;
+        bool running_;
+        std::size_t pending_;
+        Statistics statistics_;
+        std::deque<Part> queue_;
+        std::vector<Frame> frames_;
+        mutable std::mutex mutex_;
+        std::condition_variable idle_;
+        std::thread thread_;
+    };
+}
+
+#endif /* VLT_HPP_ */
@@ -0,0 +1,323 @@
+
+// Backup/restore of the AT24CM02 vault over the VLT frame protocol.
+//
+// vltbackup [-b baudrate] [-o offset] <device> dump <file> [address [length]]
+// vltbackup [-b baudrate] [-o offset] <device> restore <file> [address]
+//
+// The board has to be unlocked and in command mode ("> " prompt).
+// -o resumes an interrupted transfer at offset bytes into the image.
+
+#include "../common/frame.h"
+#include "../common/serial.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define VLT_SIZE 0x40000UL
+#define VLT_TIMEOUT 1500
+#define VLT_RETRIES 5
+#define VLT_WINDOW 2
+
+static unsigned char vlt_sequence = 0;
+
+static double vlt_time(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + ((double)now.tv_nsec / 1e9);
+}
+
+static int vlt_request(int fd, FRAME_Command command, unsigned long address, unsigned long length)
+{
+    unsigned char payload[2 * FRAME_ADDRESS_SIZE];
+
+    frame_set_address(&payload[0], address);
+    frame_set_address(&payload[FRAME_ADDRESS_SIZE], length);
+
+    return frame_write(fd, command, vlt_sequence++, payload, sizeof(payload));
+}
+
+// Discards whatever is still in flight from an aborted transfer
+static void vlt_drain(int fd)
+{
+    FRAME_Data frame;
+
+    while(frame_read(fd, &frame, 100) != FRAME_Status_Timeout);
+}
+
+static int vlt_dump(int fd, FILE *file, unsigned long address, unsigned long end)
+{
+    FRAME_Data frame;
+    int retries = VLT_RETRIES;
+
+    while(address < end)
+    {
+        if(vlt_request(fd, FRAME_Command_Dump, address, end - address) < 0)
+        {
+            return -1;
+        }
+
+        while(address < end)
+        {
+            FRAME_Status status = frame_read(fd, &frame, VLT_TIMEOUT);
+
+            if(status == FRAME_Status_Error)
+            {
+                return -1;
+            }
+
+            if(status == FRAME_Status_Ready)
+            {
+                // Acks and chunks of an aborted stream are skipped
+                if(	(frame.command != FRAME_Command_Data) ||
+                    (frame.length <= FRAME_ADDRESS_SIZE) ||
+                    (frame_get_address(frame.payload) != address))
+                {
+                    continue;
+                }
+
+                unsigned int length = frame.length - FRAME_ADDRESS_SIZE;
+
+                if(fwrite(&frame.payload[FRAME_ADDRESS_SIZE], 1, length, file) != length)
+                {
+                    return -1;
+                }
+                address += length;
+                retries = VLT_RETRIES;
+
+                if(!(address % 0x1000UL))
+                {
+                    fprintf(stderr, "\rdump: 0x%05lx", address);
+                }
+                continue;
+            }
+
+            // Timeout or corrupt chunk: resume at the first missing address
+            fprintf(stderr, "\ndump: %s at 0x%05lx, resuming\n", (status == FRAME_Status_Corrupt) ? "crc error" : "timeout", address);
+
+            if(!(retries--))
+            {
+                return -1;
+            }
+            break;
+        }
+    }
+    fprintf(stderr, "\n");
+    return 0;
+}
+
+static int vlt_restore(int fd, const unsigned char *image, unsigned long address, unsigned long end)
+{
+    FRAME_Data frame;
+    FRAME_Status status;
+    unsigned long acknowledged = address;
+    int retries = VLT_RETRIES + 1;
+
+    while(acknowledged < end)
+    {
+        unsigned long sent = acknowledged;
+        unsigned char inflight = 0;
+
+        if(!(retries--))
+        {
+            return -1;
+        }
+
+        vlt_drain(fd);
+
+        if(vlt_request(fd, FRAME_Command_Restore, acknowledged, end - acknowledged) < 0)
+        {
+            return -1;
+        }
+
+        // Wait for the device to accept the request at the expected address
+        do
+        {
+            status = frame_read(fd, &frame, VLT_TIMEOUT);
+        } while((status != FRAME_Status_Timeout) && (status != FRAME_Status_Error) &&
+                ((status != FRAME_Status_Ready) || (frame.command != FRAME_Command_Ack) || (frame_get_address(frame.payload) != acknowledged)));
+
+        if(status == FRAME_Status_Error)
+        {
+            return -1;
+        }
+
+        if(status == FRAME_Status_Timeout)
+        {
+            fprintf(stderr, "\nrestore: no response at 0x%05lx, retrying\n", acknowledged);
+            continue;
+        }
+
+        while(acknowledged < end)
+        {
+            // Keep the device's second receive buffer busy while it programs
+            while((inflight < VLT_WINDOW) && (sent < end))
+            {
+                unsigned char payload[FRAME_ADDRESS_SIZE + FRAME_CHUNK_SIZE];
+                unsigned long length = FRAME_CHUNK_SIZE - (sent % FRAME_CHUNK_SIZE);
+
+                if(length > (end - sent))
+                {
+                    length = end - sent;
+                }
+
+                frame_set_address(payload, sent);
+                memcpy(&payload[FRAME_ADDRESS_SIZE], &image[sent - address], length);
+
+                if(frame_write(fd, FRAME_Command_Data, vlt_sequence++, payload, (unsigned char)(FRAME_ADDRESS_SIZE + length)) < 0)
+                {
+                    return -1;
+                }
+                sent += length;
+                inflight++;
+            }
+
+            status = frame_read(fd, &frame, VLT_TIMEOUT);
+
+            if(status == FRAME_Status_Error)
+            {
+                return -1;
+            }
+
+            if((status == FRAME_Status_Ready) && (frame.command == FRAME_Command_Ack))
+            {
+                unsigned long confirmed = frame_get_address(frame.payload);
+
+                if((confirmed > acknowledged) && (confirmed <= sent))
+                {
+                    acknowledged = confirmed;
+                    inflight--;
+                    retries = VLT_RETRIES + 1;
+
+                    if(!(acknowledged % 0x1000UL))
+                    {
+                        fprintf(stderr, "\rrestore: 0x%05lx", acknowledged);
+                    }
+                }
+                continue;
+            }
+
+            fprintf(stderr, "\nrestore: %s at 0x%05lx, resuming\n", (status == FRAME_Status_Timeout) ? "timeout" : "rejected chunk", acknowledged);
+            break;
+        }
+    }
+    fprintf(stderr, "\n");
+    return 0;
+}
+
+static void vlt_usage(void)
+{
+    fprintf(stderr, "usage: vltbackup [-b baudrate] [-o offset] <device> dump <file> [address [length]]\n");
+    fprintf(stderr, "       vltbackup [-b baudrate] [-o offset] <device> restore <file> [address]\n");
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned long baudrate = 115200UL;
+    unsigned long offset = 0UL;
+    unsigned long address = 0UL;
+    unsigned long length = VLT_SIZE;
+    double start;
+    int option;
+    int fd;
+    int status;
+
+    while((option = getopt(argc, argv, "b:o:")) != -1)
+    {
+        switch(option)
+        {
+            case 'b': baudrate = strtoul(optarg, NULL, 0); break;
+            case 'o': offset = strtoul(optarg, NULL, 0); break;
+            default: vlt_usage(); return 2;
+        }
+    }
+
+    if((argc - optind) < 3)
+    {
+        vlt_usage();
+        return 2;
+    }
+
+    if((argc - optind) > 3)
+    {
+        address = strtoul(argv[optind + 3], NULL, 0);
+    }
+
+    if((argc - optind) > 4)
+    {
+        length = strtoul(argv[optind + 4], NULL, 0);
+    }
+
+    if((address >= VLT_SIZE) || (length > (VLT_SIZE - address)))
+    {
+        length = (address < VLT_SIZE) ? (VLT_SIZE - address) : 0UL;
+    }
+
+    fd = serial_open(argv[optind], baudrate);
+
+    if(fd < 0)
+    {
+        fprintf(stderr, "%s: %s\n", argv[optind], strerror(errno));
+        return 1;
+    }
+
+    start = vlt_time();
+
+    if(!strcmp(argv[optind + 1], "dump"))
+    {
+        FILE *file = fopen(argv[optind + 2], offset ? "r+b" : "wb");
+
+        if(!file || fseek(file, (long)offset, SEEK_SET))
+        {
+            fprintf(stderr, "%s: %s\n", argv[optind + 2], strerror(errno));
+            return 1;
+        }
+
+        length = (offset < length) ? (length - offset) : 0UL;
+        status = vlt_dump(fd, file, address + offset, address + offset + length);
+        fclose(file);
+    }
+    else if(!strcmp(argv[optind + 1], "restore"))
+    {
+        FILE *file = fopen(argv[optind + 2], "rb");
+        unsigned char *image = malloc(VLT_SIZE);
+
+        if(!file || !image)
+        {
+            fprintf(stderr, "%s: %s\n", argv[optind + 2], strerror(errno));
+            return 1;
+        }
+
+        size_t size = fread(image, 1, VLT_SIZE, file);
+        fclose(file);
+
+        if(size > length)
+        {
+            size = length;
+        }
+        length = (offset < size) ? (size - offset) : 0UL;
+        status = vlt_restore(fd, image + offset, address + offset, address + offset + length);
+        free(image);
+    }
+    else
+    {
+        vlt_usage();
+        return 2;
+    }
+
+    serial_close(fd);
+
+    if(status < 0)
+    {
+        fprintf(stderr, "transfer failed, resume with -o <offset>\n");
+        return 1;
+    }
+
+    fprintf(stderr, "%lu bytes in %.2fs (%.0f bytes/s)\n", length, vlt_time() - start, length / (vlt_time() - start));
+    return 0;
+}
@@ -0,0 +1,305 @@
+
+#include "simulator.hpp"
+
+extern "C"
+{
+    #include "../common/frame.h"
+}
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <random>
+#include <system_error>
+#include <termios.h>
+#include <unistd.h>
+
+#define SIMULATOR_VAULT_SIZE 0x40000UL
+#define SIMULATOR_PAGE_SIZE 256U
+#define SIMULATOR_STATUS_SIZE 28U
+#define SIMULATOR_RESERVE_DATA 248U
+#define SIMULATOR_RESERVE_SIZE (125U * SIMULATOR_RESERVE_DATA)
+#define SIMULATOR_BUFFERS 2U
+#define SIMULATOR_POLL_INTERVAL 20
+#define SIMULATOR_USB_PACKET 62U
+
+namespace vlt
+{
+    Simulator::Simulator(const Timing &timing)
+        : timing_(timing), master_(-1), slave_(-1), running_(true), busy_(false), dropped_(0), reserve_(SIMULATOR_RESERVE_SIZE),
+          memory_(SIMULATOR_VAULT_SIZE, 0xFF), downlink_(Clock::now())
+    {
+        struct termios tty;
+
+        master_ = posix_openpt(O_RDWR | O_NOCTTY);
+
+        if((master_ < 0) || grantpt(master_) || unlockpt(master_))
+        {
+            throw std::system_error(errno, std::generic_category(), "pty");
+        }
+        device_ = ptsname(master_);
+
+        // Kept open, the pty would hang up between two clients
+        slave_ = open(device_.c_str(), O_RDWR | O_NOCTTY);
+
+        if((slave_ < 0) || tcgetattr(slave_, &tty))
+        {
+            throw std::system_error(errno, std::generic_category(), device_);
+        }
+        cfmakeraw(&tty);
+        tcsetattr(slave_, TCSANOW, &tty);
+
+        receiver_ = std::thread(&Simulator::receive, this);
+        processor_ = std::thread(&Simulator::process, this);
+        transmitter_ = std::thread(&Simulator::transmit, this);
+    }
+
+    Simulator::~Simulator()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_ = false;
+        }
+        request_ready_.notify_all();
+        reply_ready_.notify_all();
+
+        receiver_.join();
+        processor_.join();
+        transmitter_.join();
+
+        close(slave_);
+        close(master_);
+    }
+
+    unsigned long Simulator::dropped() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        return dropped_;
+    }
+
+    // START | COMMAND | SEQUENCE | LENGTH | PAYLOAD | CRC16, 10 bits per byte
+    Simulator::Clock::duration Simulator::wire(std::size_t length) const
+    {
+        return std::chrono::microseconds(((6U + length) * 10000000ULL) / timing_.baudrate);
+    }
+
+    // Device address, memory address (2 bytes), restart and data, 9 bits per byte
+    Simulator::Clock::duration Simulator::twi(std::size_t length) const
+    {
+        return std::chrono::microseconds(((4U + length) * 9000000ULL) / timing_.twi);
+    }
+
+    void Simulator::receive()
+    {
+        Clock::time_point uplink = Clock::now();
+
+        while(1)
+        {
+            FRAME_Data frame;
+            FRAME_Status status = frame_read(master_, &frame, SIMULATOR_POLL_INTERVAL);
+
+            if(status == FRAME_Status_Timeout)
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+
+                if(!running_)
+                {
+                    return;
+                }
+                continue;
+            }
+
+            // The frame is complete after its last byte passed the UART
+            uplink = std::max(uplink, Clock::now()) + wire(frame.length);
+            std::this_thread::sleep_until(uplink);
+
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            if((status != FRAME_Status_Ready) || ((requests_.size() + (busy_ ? 1U : 0U)) >= SIMULATOR_BUFFERS))
+            {
+                dropped_++;
+                continue;
+            }
+            requests_.push_back(Frame{ frame.command, frame.sequence, std::vector<std::uint8_t>(frame.payload, frame.payload + frame.length) });
+            request_ready_.notify_one();
+        }
+    }
+
+    void Simulator::process()
+    {
+        std::mt19937 generator(std::random_device{}());
+        Clock::time_point start = Clock::now();
+
+        while(1)
+        {
+            Frame frame;
+
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+
+                request_ready_.wait(lock, [this] { return !running_ || !requests_.empty(); });
+
+                if(!running_)
+                {
+                    return;
+                }
+
+                frame = std::move(requests_.front());
+                requests_.pop_front();
+                busy_ = (frame.command == FRAME_Command_Write);
+            }
+
+            std::vector<std::uint8_t> payload(FRAME_ADDRESS_SIZE, 0);
+            std::uint8_t command = FRAME_Command_Nak;
+            unsigned long address = (frame.payload.size() >= FRAME_ADDRESS_SIZE) ? frame_get_address(frame.payload.data()) : 0UL;
+
+            if(	(frame.command == FRAME_Command_Read) && (frame.payload.size() == (FRAME_ADDRESS_SIZE + 1)) &&
+                frame.payload[FRAME_ADDRESS_SIZE] && (frame.payload[FRAME_ADDRESS_SIZE] <= FRAME_CHUNK_SIZE) &&
+                ((address + frame.payload[FRAME_ADDRESS_SIZE]) <= SIMULATOR_VAULT_SIZE))
+            {
+                std::size_t length = frame.payload[FRAME_ADDRESS_SIZE];
+
+                std::this_thread::sleep_for(twi(length));
+
+                command = FRAME_Command_Data;
+                frame_set_address(payload.data(), address);
+                payload.insert(payload.end(), memory_.begin() + address, memory_.begin() + address + length);
+            }
+            else if((frame.command == FRAME_Command_Write) && (frame.payload.size() > FRAME_ADDRESS_SIZE) &&
+                    ((address + frame.payload.size() - FRAME_ADDRESS_SIZE) <= SIMULATOR_VAULT_SIZE) &&
+                    (((address % SIMULATOR_PAGE_SIZE) + frame.payload.size() - FRAME_ADDRESS_SIZE) <= SIMULATOR_PAGE_SIZE))
+            {
+                std::size_t length = frame.payload.size() - FRAME_ADDRESS_SIZE;
+
+                std::this_thread::sleep_for(twi(length) + timing_.write_cycle);
+                std::copy(frame.payload.begin() + FRAME_ADDRESS_SIZE, frame.payload.end(), memory_.begin() + address);
+
+                command = FRAME_Command_Ack;
+                frame_set_address(payload.data(), address + length);
+            }
+            else if((frame.command == FRAME_Command_Reserve) && (frame.payload.size() == 1) &&
+                    frame.payload[0] && (frame.payload[0] <= FRAME_CHUNK_SIZE) && (reserve_ >= frame.payload[0]))
+            {
+                unsigned long offset = (SIMULATOR_RESERVE_SIZE - reserve_) % SIMULATOR_RESERVE_DATA;
+                std::size_t length = frame.payload[0];
+
+                std::this_thread::sleep_for(twi(length));
+
+                // Page erase after its last byte
+                if((offset + length) >= SIMULATOR_RESERVE_DATA)
+                {
+                    std::this_thread::sleep_for(twi(SIMULATOR_PAGE_SIZE) + timing_.write_cycle);
+                }
+                reserve_ -= length;
+
+                command = FRAME_Command_Data;
+
+                for (unsigned int i=0; i < length; i++)
+                {
+                    payload.push_back(static_cast<std::uint8_t>(generator()));
+                }
+            }
+            else if(((frame.command == FRAME_Command_Random) || (frame.command == FRAME_Command_Reserve)) &&
+                    (frame.payload.size() == 1) && frame.payload[0] && (frame.payload[0] <= FRAME_CHUNK_SIZE))
+            {
+                if(timing_.random_rate)
+                {
+                    std::this_thread::sleep_for(std::chrono::microseconds((frame.payload[0] * 1000000ULL) / timing_.random_rate));
+                }
+
+                command = FRAME_Command_Data;
+
+                for (unsigned int i=0; i < frame.payload[0]; i++)
+                {
+                    payload.push_back(static_cast<std::uint8_t>(generator()));
+                }
+            }
+            else if(frame.command == FRAME_Command_Status)
+            {
+                unsigned long uptime = static_cast<unsigned long>(std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count());
+
+                command = FRAME_Command_Data;
+                payload.resize(FRAME_ADDRESS_SIZE + SIMULATOR_STATUS_SIZE, 0);
+
+                for (unsigned int i=0; i < 4; i++)
+                {
+                    payload[FRAME_ADDRESS_SIZE + i] = static_cast<std::uint8_t>(uptime >> (8 * i));
+                }
+                frame_set_address(&payload[FRAME_ADDRESS_SIZE + 21], reserve_);
+            }
+
+            // Like the firmware: the reply waits until the previous one is sent
+            Clock::time_point previous;
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                previous = downlink_;
+            }
+            std::this_thread::sleep_until(previous);
+
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            busy_ = false;
+            reply(command, frame.sequence, payload);
+        }
+    }
+
+    // Queues a reply, it is delivered after its last byte passed the UART (called with the lock held)
+    void Simulator::reply(std::uint8_t command, std::uint8_t sequence, const std::vector<std::uint8_t> &payload)
+    {
+        std::vector<std::uint8_t> data{ FRAME_START, command, sequence, static_cast<std::uint8_t>(payload.size()) };
+        unsigned int crc;
+
+        data.insert(data.end(), payload.begin(), payload.end());
+        crc = frame_crc(0, &data[1], static_cast<unsigned int>(data.size() - 1));
+        data.push_back(static_cast<std::uint8_t>(crc));
+        data.push_back(static_cast<std::uint8_t>(crc >> 8));
+
+        downlink_ = std::max(downlink_, Clock::now()) + wire(payload.size());
+        replies_.push_back(Reply{ downlink_, std::move(data) });
+        reply_ready_.notify_one();
+    }
+
+    void Simulator::transmit()
+    {
+        while(1)
+        {
+            Reply reply;
+
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+
+                reply_ready_.wait(lock, [this] { return !running_ || !replies_.empty(); });
+
+                if(!running_)
+                {
+                    return;
+                }
+
+                reply = std::move(replies_.front());
+                replies_.pop_front();
+            }
+
+            std::this_thread::sleep_until(reply.delivery);
+
+            std::size_t full = timing_.latency.count() ? (reply.data.size() / SIMULATOR_USB_PACKET) * SIMULATOR_USB_PACKET : reply.data.size();
+
+            if(full && (write(master_, reply.data.data(), full) < 0))
+            {
+                return;
+            }
+
+            if(full < reply.data.size())
+            {
+                std::this_thread::sleep_for(timing_.latency);
+
+                if(write(master_, reply.data.data() + full, reply.data.size() - full) < 0)
+                {
+                    return;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,94 @@
+
+#ifndef SIMULATOR_HPP_
+#define SIMULATOR_HPP_
+
+// pty device simulator for the single request frames of VLT_FW_1_0
+// (Read, Write, Random, Reserve, Status).
+//
+// Both directions of the UART are timed with the baudrate (10 bits per
+// byte), Read/Write add the TWI transfer and the AT24CM02 write cycle.
+// The entropy reserve starts full, every used up page is erased.
+// Like the firmware it has two receive buffers: a request is released
+// when it is taken up, a write only after the page is written, frames
+// arriving with both buffers in use are dropped.
+// With a latency the replies reach the host like through a USB adapter:
+// full 62 byte packets at once, the rest when the latency timer expires.
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace vlt
+{
+    struct Timing
+    {
+        unsigned long baudrate = 115200UL;
+        unsigned long twi = 400000UL;
+        std::chrono::microseconds write_cycle{5000};
+        unsigned long random_rate = 0;
+        std::chrono::milliseconds latency{0};
+    };
+
+    class Simulator
+    {
+    public:
+        explicit Simulator(const Timing &timing = Timing());
+        ~Simulator();
+
+        Simulator(const Simulator &) = delete;
+        Simulator &operator=(const Simulator &) = delete;
+
+        const std::string &device() const { return device_; }
+        unsigned long dropped() const;
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        struct Frame
+        {
+            std::uint8_t command;
+            std::uint8_t sequence;
+            std::vector<std::uint8_t> payload;
+        };
+
+        struct Reply
+        {
+            Clock::time_point delivery;
+            std::vector<std::uint8_t> data;
+        };
+
+        Clock::duration wire(std::size_t length) const;
+        Clock::duration twi(std::size_t length) const;
+
+        void receive();
+        void process();
+        void transmit();
+        void reply(std::uint8_t command, std::uint8_t sequence, const std::vector<std::uint8_t> &payload);
+
+        Timing timing_;
+        int master_;
+        int slave_;
+        std::string device_;
+        bool running_;
+        bool busy_;
+        unsigned long dropped_;
+        unsigned long reserve_;
+        std::vector<std::uint8_t> memory_;
+        std::deque<Frame> requests_;
+        std::deque<Reply> replies_;
+        Clock::time_point downlink_;
+        mutable std::mutex mutex_;
+        std::condition_variable request_ready_;
+        std::condition_variable reply_ready_;
+        std::thread receiver_;
+        std::thread processor_;
+        std::thread transmitter_;
+    };
+}
+
+#endif /* SIMULATOR_HPP_ */
@@ -0,0 +1,236 @@
+
+// Throughput of the libvlt client, requests and bytes per second.
+//
+// vltbench [-b baudrate] [-r random rate] [-l latency] [-n count] [-w] [device]
+//
+// Without a device the built-in pty simulator is used (UART and TWI
+// timing, AT24CM02 write cycle, -r limits the live random bytes per
+// second, the entropy reserve is served at EEPROM speed, -l delays the
+// end of every reply like a USB adapter latency timer in ms).
+// Every scenario runs with a single frame in flight and pipelined, small
+// requests also with and without batching. Writes to a real device are
+// only done with -w, they overwrite 0x20000-0x23FFF of the vault.
+
+#include "../libvlt/vlt.hpp"
+#include "simulator.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#define VLTBENCH_ADDRESS 0x20000UL
+#define VLTBENCH_SIZE 0x4000UL
+#define VLTBENCH_CHUNK_SIZE 64U
+
+struct Scenario
+{
+    const char *name;
+    std::size_t size;
+    unsigned int window;
+    bool batching;
+};
+
+static std::atomic<unsigned long> vltbench_failed(0);
+
+static void vltbench_done(vlt::Result result)
+{
+    if(result != vlt::Result::Ok)
+    {
+        vltbench_failed++;
+    }
+}
+
+// Submits all requests at once, the client keeps the window filled
+static void vltbench_run(const std::string &device, const vlt::Options &defaults, const Scenario &scenario, unsigned long count,
+                         const std::function<void(vlt::Client &, unsigned long)> &submit)
+{
+    vlt::Options options = defaults;
+
+    options.window = scenario.window;
+    options.batching = scenario.batching;
+
+    vlt::Client client(device, options);
+
+    vltbench_failed = 0;
+
+    auto begin = std::chrono::steady_clock::now();
+
+    for (unsigned long i=0; i < count; i++)
+    {
+        submit(client, i);
+    }
+    client.flush();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    vlt::Statistics statistics = client.statistics();
+
+    std::printf("%-12s %5zu %6u %-5s %7lu %7lu %8.0f %9.0f %7lu %6lu\n",
+                scenario.name, scenario.size, scenario.window, scenario.batching ? "on" : "off",
+                count, (unsigned long)statistics.frames,
+                count / seconds, statistics.bytes / seconds,
+                (unsigned long)statistics.retries, vltbench_failed.load());
+}
+
+static void vltbench_usage(void)
+{
+    std::fprintf(stderr, "usage: vltbench [-b baudrate] [-r random rate] [-l latency] [-n count] [-w] [device]\n");
+}
+
+int main(int argc, char *argv[])
+{
+    vlt::Options options;
+    vlt::Timing timing;
+    std::unique_ptr<vlt::Simulator> simulator;
+    std::string device;
+    unsigned long count = 256;
+    bool writes = false;
+    int option;
+
+    while((option = getopt(argc, argv, "b:r:l:n:w")) != -1)
+    {
+        switch(option)
+        {
+            case 'b': options.baudrate = timing.baudrate = std::strtoul(optarg, NULL, 0); break;
+            case 'r': timing.random_rate = std::strtoul(optarg, NULL, 0); break;
+            case 'l': timing.latency = std::chrono::milliseconds(std::strtoul(optarg, NULL, 0)); break;
+            case 'n': count = std::strtoul(optarg, NULL, 0); break;
+            case 'w': writes = true; break;
+            default: vltbench_usage(); return 2;
+        }
+    }
+
+    if((argc - optind) > 1 || !count)
+    {
+        vltbench_usage();
+        return 2;
+    }
+
+    try
+    {
+        if(optind < argc)
+        {
+            device = argv[optind];
+        }
+        else
+        {
+            simulator.reset(new vlt::Simulator(timing));
+            device = simulator->device();
+            writes = true;
+        }
+
+        std::vector<std::uint8_t> data(VLTBENCH_SIZE);
+        std::vector<std::uint8_t> check(VLTBENCH_SIZE);
+        std::vector<vlt::Status> status(count);
+
+        for (std::size_t i=0; i < data.size(); i++)
+        {
+            data[i] = static_cast<std::uint8_t>((i * 7U) ^ (i >> 8));
+        }
+
+        std::printf("%-12s %5s %6s %-5s %7s %7s %8s %9s %7s %6s\n",
+                    "request", "bytes", "window", "batch", "count", "frames", "req/s", "B/s", "retries", "failed");
+
+        for (unsigned int window=1; window <= 2; window++)
+        {
+            Scenario scenario = { "status", 28, window, false };
+
+            vltbench_run(device, options, scenario, count, [&status](vlt::Client &client, unsigned long i)
+            {
+                client.status(&status[i], vltbench_done);
+            });
+        }
+
+        for (std::size_t size : { 8U, 64U })
+        {
+            for (unsigned int window=1; window <= 2; window++)
+            {
+                for (bool batching : { false, true })
+                {
+                    Scenario scenario = { "random", size, window, batching };
+
+                    if((size == VLTBENCH_CHUNK_SIZE) && batching)
+                    {
+                        continue;
+                    }
+
+                    vltbench_run(device, options, scenario, count, [&check, size](vlt::Client &client, unsigned long i)
+                    {
+                        client.random(&check[(i * size) % (VLTBENCH_SIZE - size)], size, vltbench_done);
+                    });
+                }
+            }
+        }
+
+        // Consumes (and erases) count * 64 bytes of the reserve
+        for (unsigned int window=1; window <= 2; window++)
+        {
+            Scenario scenario = { "reserve", VLTBENCH_CHUNK_SIZE, window, false };
+
+            vltbench_run(device, options, scenario, count, [&check](vlt::Client &client, unsigned long i)
+            {
+                client.reserve(&check[(i * VLTBENCH_CHUNK_SIZE) % (VLTBENCH_SIZE - VLTBENCH_CHUNK_SIZE)], VLTBENCH_CHUNK_SIZE, vltbench_done);
+            });
+        }
+
+        if(writes)
+        {
+            for (unsigned int window=1; window <= 2; window++)
+            {
+                Scenario scenario = { "write", 64, window, false };
+
+                vltbench_run(device, options, scenario, VLTBENCH_SIZE / 64U, [&data](vlt::Client &client, unsigned long i)
+                {
+                    client.write(VLTBENCH_ADDRESS + (i * 64U), &data[i * 64U], 64U, vltbench_done);
+                });
+            }
+        }
+
+        for (std::size_t size : { 16U, 64U })
+        {
+            for (unsigned int window=1; window <= 2; window++)
+            {
+                for (bool batching : { false, true })
+                {
+                    Scenario scenario = { "read", size, window, batching };
+
+                    if((size == VLTBENCH_CHUNK_SIZE) && batching)
+                    {
+                        continue;
+                    }
+
+                    std::memset(check.data(), 0, check.size());
+
+                    vltbench_run(device, options, scenario, VLTBENCH_SIZE / size, [&check, size](vlt::Client &client, unsigned long i)
+                    {
+                        client.read(VLTBENCH_ADDRESS + (i * size), &check[i * size], size, vltbench_done);
+                    });
+
+                    if(writes && (check != data))
+                    {
+                        std::fprintf(stderr, "read: data differs from the written pattern\n");
+                        return 1;
+                    }
+                }
+            }
+        }
+
+        if(simulator)
+        {
+            std::printf("simulator: %lu dropped frames\n", simulator->dropped());
+        }
+    }
+    catch(const std::exception &error)
+    {
+        std::fprintf(stderr, "%s\n", error.what());
+        return 1;
+    }
+    return 0;
+}
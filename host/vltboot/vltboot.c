@@ -0,0 +1,242 @@
+
+// Firmware update over the VLT_BOOT_1_0 UART bootloader.
+//
+// vltboot [-b baudrate] [-B baudrate] [-r] <device> <image.bin>
+//
+// image.bin is the application linked behind the bootloader
+// (-Wl,--section-start=.text=0x400) and converted with
+// avr-objcopy -O binary -R .eeprom.
+// -r sends "reset" to an unlocked board in command mode, otherwise the
+// board has to be power cycled while vltboot waits for the bootloader.
+
+#include "../common/frame.h"
+#include "../common/serial.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define VLT_FLASH_SIZE 0x4000UL
+#define VLT_PAGE_SIZE FRAME_CHUNK_SIZE
+#define VLT_SYNC_INTERVAL 50
+#define VLT_SYNC_TIMEOUT 30.0
+#define VLT_TIMEOUT 500
+#define VLT_RETRIES 5
+
+static unsigned char vlt_sequence = 0;
+
+static double vlt_time(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + ((double)now.tv_nsec / 1e9);
+}
+
+// Sends a frame and waits for the Ack/Nak with the same sequence number
+static FRAME_Command vlt_transfer(int fd, FRAME_Command command, const unsigned char *payload, unsigned char length, FRAME_Data *reply, int timeout)
+{
+    unsigned char sequence = vlt_sequence++;
+    FRAME_Status status;
+
+    if(frame_write(fd, command, sequence, payload, length) < 0)
+    {
+        return 0;
+    }
+
+    do
+    {
+        status = frame_read(fd, reply, timeout);
+    } while((status == FRAME_Status_Corrupt) || ((status == FRAME_Status_Ready) && (reply->sequence != sequence)));
+
+    if((status != FRAME_Status_Ready) || (reply->length < (2 * FRAME_ADDRESS_SIZE)))
+    {
+        return 0;
+    }
+    return reply->command;
+}
+
+// Retries a transfer until it is acknowledged
+static int vlt_request(int fd, FRAME_Command command, const unsigned char *payload, unsigned char length, FRAME_Data *reply)
+{
+    for (int retries = VLT_RETRIES; retries; retries--)
+    {
+        if(vlt_transfer(fd, command, payload, length, reply, VLT_TIMEOUT) == FRAME_Command_Ack)
+        {
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static int vlt_sync(int fd, unsigned long *start, unsigned long *size)
+{
+    FRAME_Data reply;
+    double timeout = vlt_time() + VLT_SYNC_TIMEOUT;
+
+    fprintf(stderr, "waiting for bootloader (reset or power cycle the board)\n");
+
+    while(vlt_time() < timeout)
+    {
+        if(vlt_transfer(fd, FRAME_Command_Boot, (const unsigned char *)"", 0, &reply, VLT_SYNC_INTERVAL) == FRAME_Command_Ack)
+        {
+            *start = frame_get_address(&reply.payload[0]);
+            *size = frame_get_address(&reply.payload[FRAME_ADDRESS_SIZE]);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static int vlt_program(int fd, const unsigned char *image, unsigned long start, unsigned long length)
+{
+    FRAME_Data reply;
+
+    for (unsigned long offset = 0; offset < length; offset += VLT_PAGE_SIZE)
+    {
+        unsigned char payload[FRAME_ADDRESS_SIZE + VLT_PAGE_SIZE];
+
+        frame_set_address(payload, start + offset);
+        memcpy(&payload[FRAME_ADDRESS_SIZE], &image[offset], VLT_PAGE_SIZE);
+
+        if(	vlt_request(fd, FRAME_Command_Program, payload, sizeof(payload), &reply) ||
+            (frame_get_address(reply.payload) != (start + offset + VLT_PAGE_SIZE)))
+        {
+            fprintf(stderr, "\nprogram: failed at 0x%04lx\n", start + offset);
+            return -1;
+        }
+
+        if(!((start + offset + VLT_PAGE_SIZE) % 0x400UL))
+        {
+            fprintf(stderr, "\rprogram: 0x%04lx", start + offset + VLT_PAGE_SIZE);
+        }
+    }
+    fprintf(stderr, "\n");
+    return 0;
+}
+
+static void vlt_usage(void)
+{
+    fprintf(stderr, "usage: vltboot [-b baudrate] [-B baudrate] [-r] <device> <image.bin>\n");
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned long baudrate = 115200UL;
+    unsigned long bootrate = 500000UL;
+    unsigned long start;
+    unsigned long size;
+    unsigned char image[VLT_FLASH_SIZE];
+    unsigned char payload[FRAME_ADDRESS_SIZE + 2];
+    FRAME_Data reply;
+    unsigned int crc;
+    size_t length;
+    int reset = 0;
+    int option;
+    int fd;
+    FILE *file;
+    double begin;
+
+    while((option = getopt(argc, argv, "b:B:r")) != -1)
+    {
+        switch(option)
+        {
+            case 'b': baudrate = strtoul(optarg, NULL, 0); break;
+            case 'B': bootrate = strtoul(optarg, NULL, 0); break;
+            case 'r': reset = 1; break;
+            default: vlt_usage(); return 2;
+        }
+    }
+
+    if((argc - optind) != 2)
+    {
+        vlt_usage();
+        return 2;
+    }
+
+    file = fopen(argv[optind + 1], "rb");
+
+    if(!file)
+    {
+        fprintf(stderr, "%s: %s\n", argv[optind + 1], strerror(errno));
+        return 1;
+    }
+
+    length = fread(image, 1, sizeof(image), file);
+    fclose(file);
+
+    if(!length)
+    {
+        fprintf(stderr, "%s: empty image\n", argv[optind + 1]);
+        return 1;
+    }
+
+    if(reset)
+    {
+        fd = serial_open(argv[optind], baudrate);
+
+        if(fd < 0)
+        {
+            fprintf(stderr, "%s: %s\n", argv[optind], strerror(errno));
+            return 1;
+        }
+        serial_write(fd, (const unsigned char *)"\rreset\r", 7);
+        tcdrain(fd);
+        serial_close(fd);
+    }
+
+    fd = serial_open(argv[optind], bootrate);
+
+    if(fd < 0)
+    {
+        fprintf(stderr, "%s: %s\n", argv[optind], strerror(errno));
+        return 1;
+    }
+
+    if(vlt_sync(fd, &start, &size))
+    {
+        fprintf(stderr, "no response from bootloader\n");
+        return 1;
+    }
+
+    if(length > size)
+    {
+        fprintf(stderr, "%s: %lu bytes, application section has %lu bytes\n", argv[optind + 1], (unsigned long)length, size);
+        return 1;
+    }
+
+    begin = vlt_time();
+
+    // Unused bytes of the last page stay erased
+    memset(&image[length], 0xFF, sizeof(image) - length);
+    crc = frame_crc(0, image, (unsigned int)length);
+
+    if(vlt_program(fd, image, start, length))
+    {
+        return 1;
+    }
+
+    frame_set_address(payload, length);
+    payload[FRAME_ADDRESS_SIZE] = (unsigned char)crc;
+    payload[FRAME_ADDRESS_SIZE + 1] = (unsigned char)(crc >> 8);
+
+    if(vlt_request(fd, FRAME_Command_Verify, payload, sizeof(payload), &reply))
+    {
+        fprintf(stderr, "verify: CRC mismatch, bootloader stays active\n");
+        return 1;
+    }
+
+    // Not retried, a lost Ack means the application is already running
+    if(vlt_transfer(fd, FRAME_Command_Run, (const unsigned char *)"", 0, &reply, VLT_TIMEOUT) != FRAME_Command_Ack)
+    {
+        fprintf(stderr, "run: not confirmed\n");
+    }
+    serial_close(fd);
+
+    fprintf(stderr, "%lu bytes in %.2fs, CRC 0x%04x verified\n", (unsigned long)length, vlt_time() - begin, crc);
+    return 0;
+}
@@ -0,0 +1,307 @@
+
+// Fetches and decodes the TWI trace of a firmware built with TWI_TRACE_EN
+//
+// vlttrace [-b baudrate] [-o raw.bin] <device>
+// vlttrace -f raw.bin
+//
+// Prints every transaction (START..STOP) with its latency, the retries
+// (NACKed address phases, e.g. EEPROM write cycle polling) and the bus
+// utilization over the traced interval.
+
+#include "../common/frame.h"
+#include "../common/serial.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define VLT_TIMEOUT 1500
+#define VLT_TRACE_SIZE (6 + (255 * 4))
+
+enum TRACE_Event_t
+{
+    TRACE_Event_Start=1,
+    TRACE_Event_Address,
+    TRACE_Event_Data,
+    TRACE_Event_Stop,
+    TRACE_Event_Time
+};
+
+#define TRACE_FLAG_ERROR 0x80
+#define TRACE_FLAG_READ 0x40
+#define TRACE_EVENT_MASK 0x0F
+
+typedef struct
+{
+    unsigned long start;
+    unsigned long stop;
+    int address;
+    int read;
+    unsigned int bytes;
+    int error;
+} TRACE_Transaction;
+
+static int vlt_fetch(int fd, unsigned char *trace, size_t size)
+{
+    FRAME_Data frame;
+    size_t received = 0;
+
+    if(frame_write(fd, FRAME_Command_Trace, 0, NULL, 0) < 0)
+    {
+        return -1;
+    }
+
+    while(1)
+    {
+        FRAME_Status status = frame_read(fd, &frame, VLT_TIMEOUT);
+
+        if(status != FRAME_Status_Ready)
+        {
+            fprintf(stderr, "trace: %s\n", (status == FRAME_Status_Corrupt) ? "crc error" : "no response");
+            return -1;
+        }
+
+        if(frame.command == FRAME_Command_Ack)
+        {
+            return (int)received;
+        }
+
+        if(frame.command == FRAME_Command_Nak)
+        {
+            fprintf(stderr, "trace: not supported (firmware without TWI_TRACE_EN)\n");
+            return -1;
+        }
+
+        if((frame.command == FRAME_Command_Data) && (frame.length > FRAME_ADDRESS_SIZE))
+        {
+            size_t offset = frame_get_address(frame.payload);
+            size_t length = frame.length - FRAME_ADDRESS_SIZE;
+
+            if((offset != received) || ((offset + length) > size))
+            {
+                fprintf(stderr, "trace: unexpected chunk at %zu\n", offset);
+                return -1;
+            }
+            memcpy(&trace[offset], &frame.payload[FRAME_ADDRESS_SIZE], length);
+            received += length;
+        }
+    }
+}
+
+static void vlt_print(TRACE_Transaction *transaction, unsigned long first, unsigned int retries, double us)
+{
+    printf("%12.1f  0x%02x  %-5s  %5u  %-4s  %10.1f  %7u\n",
+        (transaction->start - first) * us,
+        transaction->address,
+        transaction->read ? "read" : "write",
+        transaction->bytes,
+        transaction->error ? "NACK" : "ACK",
+        (transaction->stop - transaction->start) * us,
+        retries);
+}
+
+static int vlt_decode(const unsigned char *trace, size_t size)
+{
+    TRACE_Transaction transaction;
+    unsigned long high = 0;
+    unsigned long first = 0;
+    unsigned long last = 0;
+    unsigned long busy = 0;
+    unsigned long previous = 0;
+    unsigned int transactions = 0;
+    unsigned int retries = 0;
+    unsigned int retries_total = 0;
+    int open = 0;
+    int valid = 0;
+    int retry_address = -1;
+
+    if((size < 6) || (trace[0] != 'T') || (trace[1] != 'R'))
+    {
+        fprintf(stderr, "trace: invalid dump\n");
+        return -1;
+    }
+
+    unsigned int counts = trace[2] | (trace[3] << 8);
+    unsigned int records = trace[4];
+    double us = counts ? (1000.0 / counts) : 1.0;
+
+    if(size < (6 + (records * 4U)))
+    {
+        fprintf(stderr, "trace: truncated dump\n");
+        return -1;
+    }
+
+    printf("%u records, %u lost, %u RTC counts/ms\n\n", records, trace[5], counts);
+    printf("%12s  %4s  %-5s  %5s  %-4s  %10s  %7s\n", "time[us]", "addr", "dir", "bytes", "ack", "latency[us]", "retries");
+
+    for (unsigned int i=0; i < records; i++)
+    {
+        const unsigned char *record = &trace[6 + (i * 4)];
+        unsigned char event = record[0] & TRACE_EVENT_MASK;
+        unsigned long timestamp = record[2] | (record[3] << 8);
+
+        if(event == TRACE_Event_Time)
+        {
+            high = timestamp << 16;
+            continue;
+        }
+
+        timestamp |= high;
+
+        // Dumps start with a TIME record, without one (older firmware) follow 16 bit wrap arounds
+        if(valid && (timestamp < previous))
+        {
+            timestamp += 0x10000UL;
+            high += 0x10000UL;
+        }
+        previous = timestamp;
+
+        if(!valid)
+        {
+            first = timestamp;
+            valid = 1;
+        }
+        last = timestamp;
+
+        switch(event)
+        {
+            case TRACE_Event_Start:
+                if(!open)
+                {
+                    memset(&transaction, 0, sizeof(transaction));
+                    transaction.start = timestamp;
+                    transaction.address = -1;
+                    open = 1;
+                }
+                transaction.error |= (record[0] & TRACE_FLAG_ERROR) ? 1 : 0;
+                break;
+
+            case TRACE_Event_Address:
+                if(transaction.address < 0)
+                {
+                    transaction.address = record[1];
+                }
+                transaction.read = (record[0] & TRACE_FLAG_READ) ? 1 : 0;
+                transaction.error |= (record[0] & TRACE_FLAG_ERROR) ? 1 : 0;
+                break;
+
+            case TRACE_Event_Data:
+                transaction.bytes += record[1];
+                transaction.error |= (record[0] & TRACE_FLAG_ERROR) ? 1 : 0;
+                break;
+
+            case TRACE_Event_Stop:
+                if(!open)
+                {
+                    break;
+                }
+                transaction.stop = timestamp;
+                busy += transaction.stop - transaction.start;
+                transactions++;
+                open = 0;
+
+                // NACKed transactions to the same address are retries of the next one
+                if(transaction.error)
+                {
+                    retries = (transaction.address == retry_address) ? (retries + 1) : 1;
+                    retry_address = transaction.address;
+                    retries_total++;
+                    vlt_print(&transaction, first, 0, us);
+                }
+                else
+                {
+                    vlt_print(&transaction, first, (transaction.address == retry_address) ? retries : 0, us);
+                    retries = 0;
+                    retry_address = -1;
+                }
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    printf("\n%u transactions, %u retries", transactions, retries_total);
+
+    if(last > first)
+    {
+        printf(", %.1f us traced, bus utilization %.1f%%", (last - first) * us, (100.0 * busy) / (last - first));
+    }
+    printf("\n");
+
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned char trace[VLT_TRACE_SIZE];
+    unsigned long baudrate = 115200UL;
+    const char *input = NULL;
+    const char *output = NULL;
+    int size;
+    int option;
+
+    while((option = getopt(argc, argv, "b:f:o:")) != -1)
+    {
+        switch(option)
+        {
+            case 'b': baudrate = strtoul(optarg, NULL, 0); break;
+            case 'f': input = optarg; break;
+            case 'o': output = optarg; break;
+            default:
+                fprintf(stderr, "usage: vlttrace [-b baudrate] [-o raw.bin] <device>\n       vlttrace -f raw.bin\n");
+                return 2;
+        }
+    }
+
+    if(input)
+    {
+        FILE *file = fopen(input, "rb");
+
+        if(!file)
+        {
+            perror(input);
+            return 1;
+        }
+        size = (int)fread(trace, 1, sizeof(trace), file);
+        fclose(file);
+    }
+    else
+    {
+        if(optind >= argc)
+        {
+            fprintf(stderr, "usage: vlttrace [-b baudrate] [-o raw.bin] <device>\n       vlttrace -f raw.bin\n");
+            return 2;
+        }
+
+        int fd = serial_open(argv[optind], baudrate);
+
+        if(fd < 0)
+        {
+            fprintf(stderr, "%s: %s\n", argv[optind], strerror(errno));
+            return 1;
+        }
+        size = vlt_fetch(fd, trace, sizeof(trace));
+        serial_close(fd);
+
+        if(size < 0)
+        {
+            return 1;
+        }
+    }
+
+    if(output)
+    {
+        FILE *file = fopen(output, "wb");
+
+        if(!file || (fwrite(trace, 1, (size_t)size, file) != (size_t)size) || fclose(file))
+        {
+            perror(output);
+            return 1;
+        }
+    }
+
+    return vlt_decode(trace, (size_t)size) ? 1 : 0;
+}
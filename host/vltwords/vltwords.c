@@ -0,0 +1,120 @@
+
+// Builds the wordlist image for the AT24CM02 (firmware/lib/utils/wordlist)
+//
+// vltwords <wordlist.txt> <image.bin>
+//
+// One word per line, a leading diceware number ("11111<TAB>word") is
+// skipped. Load the image with: vltbackup <device> restore image.bin 0x2C000
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define VLT_WORDLIST_SIZE 0x14000UL
+#define VLT_WORD_LENGTH 32
+
+int main(int argc, char *argv[])
+{
+    char line[256];
+    char (*words)[VLT_WORD_LENGTH] = NULL;
+    unsigned long count = 0;
+    unsigned long width = 0;
+    FILE *input;
+    FILE *output;
+
+    if(argc != 3)
+    {
+        fprintf(stderr, "usage: vltwords <wordlist.txt> <image.bin>\n");
+        return 2;
+    }
+
+    input = fopen(argv[1], "r");
+
+    if(!input)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+
+    while(fgets(line, sizeof(line), input))
+    {
+        char *word = line;
+        size_t length;
+
+        while(isdigit((unsigned char)*word))
+        {
+            word++;
+        }
+
+        while(isspace((unsigned char)*word))
+        {
+            word++;
+        }
+
+        length = strcspn(word, " \t\r\n");
+
+        if(!length)
+        {
+            continue;
+        }
+
+        if(length >= VLT_WORD_LENGTH)
+        {
+            fprintf(stderr, "%s: word too long: %.*s\n", argv[1], (int)length, word);
+            return 1;
+        }
+
+        words = realloc(words, (count + 1) * sizeof(*words));
+
+        if(!words)
+        {
+            perror("realloc");
+            return 1;
+        }
+
+        memset(words[count], 0, VLT_WORD_LENGTH);
+        memcpy(words[count], word, length);
+        count++;
+
+        if((length + 1) > width)
+        {
+            width = length + 1;
+        }
+    }
+    fclose(input);
+
+    if((count < 2) || (count > 0xFFFF) || ((8 + (count * width)) > VLT_WORDLIST_SIZE))
+    {
+        fprintf(stderr, "%s: %lu words of %lu bytes do not fit\n", argv[1], count, width);
+        return 1;
+    }
+
+    output = fopen(argv[2], "wb");
+
+    if(!output)
+    {
+        perror(argv[2]);
+        return 1;
+    }
+
+    unsigned char header[8] = { 'V', 'W', (unsigned char)count, (unsigned char)(count >> 8), (unsigned char)width, 0, 0, 0 };
+
+    fwrite(header, 1, sizeof(header), output);
+
+    for (unsigned long i=0; i < count; i++)
+    {
+        fwrite(words[i], 1, width, output);
+    }
+
+    if(fclose(output))
+    {
+        perror(argv[2]);
+        return 1;
+    }
+
+    fprintf(stderr, "%lu words, %lu bytes per slot, %lu bytes\n", count, width, 8 + (count * width));
+    free(words);
+
+    return 0;
+}